@@ -0,0 +1,83 @@
+//
+// Created by msullivan on 12/19/24.
+//
+
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+// Minimal harness shared by the benchmarks in bench/. Each benchmark is a plain executable that prints one line
+// per measurement; pass --quick to cut the iteration counts (useful to check that they still run).
+namespace bench {
+    inline bool g_Quick = false;
+
+    inline void init(int argc, char **argv)
+    {
+        for (int i = 1; i < argc; i++)
+            if (std::strcmp(argv[i], "--quick") == 0) g_Quick = true;
+    }
+
+    // Scales an iteration count down in quick mode
+    inline size_t iterations(size_t count)
+    {
+        return g_Quick ? std::max<size_t>(1, count / 100) : count;
+    }
+
+    // Keeps the compiler from optimizing away a value or the computation that produced it
+    template<typename T>
+    inline void doNotOptimize(const T &value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    struct Result {
+        double nanosecondsPerOp = 0;
+        double opsPerSecond = 0;
+    };
+
+    // Calls body(count), which must perform count operations, a few times and keeps the fastest run
+    template<typename Body>
+    Result measure(size_t count, Body &&body, int repetitions = 5)
+    {
+        using Clock = std::chrono::steady_clock;
+        double best = 0;
+        for (int i = 0; i < repetitions; i++)
+        {
+            auto start = Clock::now();
+            body(count);
+            double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            if (i == 0 || elapsed < best) best = elapsed;
+        }
+        double perOp = best / static_cast<double>(count);
+        return {perOp, perOp > 0 ? 1e9 / perOp : 0};
+    }
+
+    inline void report(std::string_view name, const Result &result)
+    {
+        std::printf("%-48.*s %12.2f ns/op %14.0f ops/s\n", static_cast<int>(name.size()), name.data(),
+                    result.nanosecondsPerOp, result.opsPerSecond);
+    }
+
+    inline void header(std::string_view title)
+    {
+        std::printf("\n== %.*s\n", static_cast<int>(title.size()), title.data());
+    }
+
+    // Small fast generator for picking benchmark inputs (xorshift64)
+    struct Random {
+        uint64_t state = 0x9e3779b97f4a7c15;
+        uint64_t next()
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            return state;
+        }
+    };
+}
@@ -0,0 +1,87 @@
+//
+// Created by msullivan on 12/19/24.
+//
+
+// Broadcast fan-out against subscriber count: queueing one payload on every subscriber's SendQueue by reference
+// (what NetworkEngine::broadcast() does) against copying it per recipient (what onReceivedBroadcast() used to
+// do). After each broadcast the queues are drained through gather()/consume() as a completed writev() would,
+// but no syscalls are made, so this isolates the fan-out cost from the kernel's.
+
+#include "Bench.h"
+#include "server/modules/SendQueue.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr size_t MAX_IOV = 64;
+
+    void drain(std::vector<SendQueue> &queues)
+    {
+        iovec iov[MAX_IOV];
+        for (SendQueue &queue : queues)
+        {
+            while (!queue.empty())
+            {
+                size_t count = queue.gather(iov, MAX_IOV);
+                size_t bytes = 0;
+                for (size_t i = 0; i < count; i++)
+                    bytes += iov[i].iov_len;
+                queue.consume(bytes);
+            }
+        }
+    }
+
+    template<bool Shared>
+    bench::Result run(size_t subscribers, size_t payloadSize)
+    {
+        std::vector<SendQueue> queues(subscribers);
+        std::string body(payloadSize, 'x');
+
+        // Fewer broadcasts for more subscribers, so each measurement does similar work
+        size_t broadcasts = std::max<size_t>(4, bench::iterations(2'000'000) / subscribers);
+
+        return bench::measure(broadcasts, [&](size_t count)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                if constexpr (Shared)
+                {
+                    auto payload = std::make_shared<const std::string>(body);
+                    for (SendQueue &queue : queues)
+                        queue.push(payload);
+                }
+                else
+                {
+                    for (SendQueue &queue : queues)
+                        queue.push(std::make_shared<const std::string>(body));
+                }
+                drain(queues);
+            }
+        }, 3);
+    }
+
+    void report(const char *name, size_t subscribers, size_t payloadSize, const bench::Result &result)
+    {
+        std::string label = std::string(name) + ", " + std::to_string(subscribers) + " subs, " +
+                            std::to_string(payloadSize) + " B";
+        bench::report(label, result);
+        std::printf("%-48s %12.0f deliveries/s\n", "", result.opsPerSecond * static_cast<double>(subscribers));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bench::init(argc, argv);
+    bench::header("Broadcast fan-out (ns and ops are per broadcast)");
+
+    for (size_t payloadSize : {128, 1024})
+    {
+        for (size_t subscribers : {10, 100, 1'000, 10'000, 100'000})
+        {
+            report("shared payload", subscribers, payloadSize, run<true>(subscribers, payloadSize));
+            report("copy per recipient", subscribers, payloadSize, run<false>(subscribers, payloadSize));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,79 @@
+//
+// Created by msullivan on 12/19/24.
+//
+
+// Cost of resolving a connection (fd) to its reactor and entity, from 10 to 100k connections: NetworkEngine's
+// FDIndex against the linear SocketInfo walk that fdToEntity() used to do. The walk is modelled on a packed
+// array, which is the best case for the registry view it replaced.
+
+#include "Bench.h"
+#include "server/modules/FDIndex.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+    struct Reactor {};
+    enum class Entity : uint32_t { Null = UINT32_MAX };
+
+    struct SocketInfo {
+        int fd;
+        Entity entity;
+    };
+
+    Entity linearLookup(const std::vector<SocketInfo> &sockets, int fd)
+    {
+        for (const SocketInfo &socket : sockets)
+            if (socket.fd == fd) return socket.entity;
+        return Entity::Null;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bench::init(argc, argv);
+    bench::header("Connection lookup (fd -> reactor, entity)");
+
+    Reactor reactor;
+    for (size_t connections : {10, 100, 1'000, 10'000, 100'000})
+    {
+        // Descriptors start above the ones a process normally has open
+        constexpr int FIRST_FD = 16;
+        FDIndex<Reactor, Entity, Entity::Null> index;
+        index.reset(FIRST_FD + connections);
+        std::vector<SocketInfo> sockets;
+        for (size_t i = 0; i < connections; i++)
+        {
+            int fd = FIRST_FD + static_cast<int>(i);
+            index.publish(fd, &reactor, static_cast<Entity>(i));
+            sockets.push_back({fd, static_cast<Entity>(i)});
+        }
+
+        // Random order, so the table isn't walked sequentially
+        std::vector<int> keys(4096);
+        bench::Random random;
+        for (int &key : keys)
+            key = FIRST_FD + static_cast<int>(random.next() % connections);
+
+        auto indexed = bench::measure(bench::iterations(20'000'000), [&](size_t count)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                int fd = keys[i & (keys.size() - 1)];
+                Reactor *owner = index.owner(fd);
+                bench::doNotOptimize(owner);
+                bench::doNotOptimize(index.entity(fd));
+            }
+        });
+        bench::report("FDIndex, " + std::to_string(connections) + " connections", indexed);
+
+        // The walk is O(n), so it gets a fixed budget of entries visited rather than of lookups
+        auto walked = bench::measure(std::max<size_t>(10, bench::iterations(200'000'000) / connections), [&](size_t count)
+        {
+            for (size_t i = 0; i < count; i++)
+                bench::doNotOptimize(linearLookup(sockets, keys[i & (keys.size() - 1)]));
+        }, 3);
+        bench::report("linear walk, " + std::to_string(connections) + " connections", walked);
+    }
+    return 0;
+}
@@ -0,0 +1,273 @@
+//
+// Created by msullivan on 12/19/24.
+//
+
+// JSON: serializing a message with JsonWriter against a naive std::stringstream serializer, and the
+// throughput of each stage-1 kernel. With --check it instead cross-checks every kernel the CPU supports against
+// the scalar one and runs the parser over inputs it must accept or reject; it exits non-zero on any failure
+// (this is the json_check test).
+
+#include "Bench.h"
+#include "common/Json.h"
+#include "common/JsonKernels.h"
+#include "common/Message.h"
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    std::string streamEscaped(std::string_view text)
+    {
+        std::ostringstream out;
+        out << '"';
+        for (char c : text)
+        {
+            switch (c)
+            {
+                case '"': out << "\\\""; break;
+                case '\\': out << "\\\\"; break;
+                case '\n': out << "\\n"; break;
+                case '\r': out << "\\r"; break;
+                case '\t': out << "\\t"; break;
+                case '\b': out << "\\b"; break;
+                case '\f': out << "\\f"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20)
+                        out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+                    else
+                        out << c;
+                break;
+            }
+        }
+        out << '"';
+        return out.str();
+    }
+
+    // The same document as writeMessageJson()
+    std::string streamMessage(const MessageView &message)
+    {
+        std::ostringstream out;
+        out << "{\"v\":" << static_cast<int>(MESSAGE_WIRE_VERSION) << ",\"sender\":" << message.senderID
+            << ",\"timestamp\":" << message.timestamp << ",\"content\":" << streamEscaped(message.content) << '}';
+        return out.str();
+    }
+
+    std::string sampleContent(size_t size)
+    {
+        std::string content;
+        while (content.size() < size)
+            content += "Client @ 127.0.0.1:40000 said \"hi\"\n";
+        content.resize(size);
+        return content;
+    }
+
+    // Blocks for the cross-check: JSON-like text, the bytes the kernels treat specially, and arbitrary bytes
+    // (including those above 0x7F, which signed SIMD comparisons get wrong)
+    std::vector<char> checkBlocks(size_t count)
+    {
+        static constexpr char ALPHABET[] = "{}[]:,\"\\ \t\n\r\x01\x1f\x20\x7f\x80\xff" "abc019.-eE";
+        bench::Random random;
+        std::vector<char> blocks(count * 64);
+        for (size_t i = 0; i < blocks.size(); i++)
+        {
+            uint64_t r = random.next();
+            blocks[i] = (i / 64) % 2 ? static_cast<char>(r) : ALPHABET[r % (sizeof(ALPHABET) - 1)];
+        }
+        return blocks;
+    }
+
+    bool checkKernels()
+    {
+        bool passed = true;
+        std::vector<char> blocks = checkBlocks(bench::iterations(200'000));
+
+        // Every byte value in every position
+        for (int value = 0; value < 256; value++)
+            blocks.insert(blocks.end(), 64, static_cast<char>(value));
+
+        const JsonKernel &reference = jsonKernels()[0];
+        for (const JsonKernel &kernel : jsonKernels().subspan(1))
+        {
+            if (!kernel.supported)
+            {
+                std::printf("%-10s skipped (not supported by this CPU)\n", kernel.name);
+                continue;
+            }
+
+            size_t mismatches = 0;
+            for (size_t offset = 0; offset < blocks.size(); offset += 64)
+            {
+                BlockMasks expected, actual;
+                reference.classify(blocks.data() + offset, expected);
+                kernel.classify(blocks.data() + offset, actual);
+                if (!(expected == actual) && mismatches++ == 0)
+                    std::printf("%-10s first mismatch in block %zu\n", kernel.name, offset / 64);
+            }
+            std::printf("%-10s %zu of %zu blocks differ from %s\n", kernel.name, mismatches, blocks.size() / 64,
+                        reference.name);
+            passed &= mismatches == 0;
+        }
+        return passed;
+    }
+
+    bool checkParser()
+    {
+        struct Case {
+            std::string_view input;
+            bool valid;
+        };
+        static constexpr Case CASES[] = {
+            {R"({"a":[1,-2,3.5e2,true,false,null],"b":{"c":"d\"\\\/\b\f\n\r\t\u00e9\ud83d\ude00"}})", true},
+            {"18446744073709551615", true},
+            {"-9223372036854775808", true},
+            {"1e-400", true},           // Underflows to zero
+            {"1.7976931348623157e308", true},
+            {"9223372036854775808", true},
+            {"9999999999999999999", true},
+            {"1e999", false},
+            {"[-1e999]", false},
+            {"\"a\tb\"", false},        // Raw control characters in strings
+            {"\"a\nb\"", false},
+            {"[\"\x01\"]", false},
+            {"\"\x7f\xc3\xa9\"", true},
+            {"01", false},
+            {"-", false},
+            {"1.", false},
+            {"1.e5", false},
+            {"[1.]", false},
+            {"1e", false},
+            {"1e+", false},
+            {"1E-}", false},
+            {"1.5e+3", true},
+            {"[1,]", false},
+            {"{\"a\" 1}", false},
+            {"\"abc", false},
+            {"\"\\x\"", false},
+            {"\"\\ud800\"", false},
+            {"[1] 2", false},
+        };
+
+        bool passed = true;
+        JsonDocument document;
+        for (const Case &test : CASES)
+        {
+            if (document.parse(test.input) == test.valid) continue;
+            std::printf("parser     %s %.*s (%s)\n", test.valid ? "rejected" : "accepted",
+                        static_cast<int>(test.input.size()), test.input.data(), document.error() ? document.error() : "no error");
+            passed = false;
+        }
+
+        // Integers above INT64_MAX keep their unsigned value and are not readable as int64_t
+        struct Integer {
+            std::string_view input;
+            uint64_t value;
+            bool fitsSigned;
+        };
+        static constexpr Integer INTEGERS[] = {
+            {"9223372036854775807", 9223372036854775807ull, true},
+            {"9223372036854775808", 9223372036854775808ull, false},
+            {"9999999999999999999", 9999999999999999999ull, false},
+            {"18446744073709551615", 18446744073709551615ull, false},
+        };
+        for (const Integer &test : INTEGERS)
+        {
+            uint64_t value = 0;
+            int64_t signedValue;
+            if (!document.parse(test.input) || !document.root().get(value) || value != test.value ||
+                document.root().get(signedValue) != test.fitsSigned)
+            {
+                std::printf("parser     read %.*s as %llu\n", static_cast<int>(test.input.size()), test.input.data(),
+                            static_cast<unsigned long long>(value));
+                passed = false;
+            }
+        }
+
+        // A long string crossing block boundaries, with a control character late in it
+        std::string longString = "\"" + std::string(200, 'x') + "\x02" + "\"";
+        if (document.parse(longString))
+        {
+            std::printf("parser     accepted a control character at offset 201\n");
+            passed = false;
+        }
+
+        // The writer's output parses back to the same message
+        std::string content = sampleContent(300) + std::string("\x01\x1f\b\\\"", 5);
+        MessageView written {42, 1734600000123456789, content}, read;
+        char buffer[1024];
+        JsonWriter writer(buffer);
+        if (!writeMessageJson(writer, written) || !document.parse(writer.view()) ||
+            !readMessageJson(document.root(), read) || read.senderID != written.senderID ||
+            read.timestamp != written.timestamp || read.content != written.content)
+        {
+            std::printf("writer     message did not round-trip\n");
+            passed = false;
+        }
+        if (writer.view() != streamMessage(written))
+        {
+            std::printf("writer     output differs from the stringstream serializer\n");
+            passed = false;
+        }
+
+        std::printf("parser     %zu cases %s\n", std::size(CASES) + std::size(INTEGERS) + 3, passed ? "passed" : "FAILED");
+        return passed;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bench::init(argc, argv);
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--check") != 0) continue;
+        bool kernels = checkKernels();
+        bool parser = checkParser();
+        return kernels && parser ? 0 : 1;
+    }
+
+    bench::header("Message serialization (ops are messages)");
+    for (size_t size : {32, 1024})
+    {
+        std::string content = sampleContent(size);
+        MessageView message {42, 1734600000123456789, content};
+        std::string label = std::to_string(size) + " B content";
+
+        std::vector<char> buffer(2 * size + 128);
+        auto writer = bench::measure(bench::iterations(2'000'000), [&](size_t count)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                JsonWriter json(buffer);
+                writeMessageJson(json, message);
+                bench::doNotOptimize(json.size());
+            }
+        });
+        bench::report("JsonWriter, " + label, writer);
+
+        auto stream = bench::measure(bench::iterations(2'000'000) / 4, [&](size_t count)
+        {
+            for (size_t i = 0; i < count; i++)
+                bench::doNotOptimize(streamMessage(message));
+        }, 3);
+        bench::report("stringstream, " + label, stream);
+    }
+
+    bench::header("Stage-1 classification (ops are 64-byte blocks)");
+    std::vector<char> blocks = checkBlocks(1024);
+    for (const JsonKernel &kernel : jsonKernels())
+    {
+        if (!kernel.supported) continue;
+        auto result = bench::measure(bench::iterations(50'000'000), [&](size_t count)
+        {
+            BlockMasks masks;
+            for (size_t i = 0; i < count; i++)
+            {
+                kernel.classify(blocks.data() + (i & 1023) * 64, masks);
+                bench::doNotOptimize(masks);
+            }
+        });
+        bench::report(kernel.name, result);
+        std::printf("%-48s %12.2f GB/s\n", "", 64 / result.nanosecondsPerOp);
+    }
+    return 0;
+}
@@ -0,0 +1,169 @@
+//
+// Created by msullivan on 12/19/24.
+//
+
+// Log calls per second against the number of threads logging at once: the ring-buffered Logger under both
+// overflow policies against the synchronous path it replaced (format, localtime, ostringstream, std::cout <<
+// std::endl on the calling thread). Output goes to a temporary file, which is read back afterwards to count
+// the lines that were actually delivered.
+
+#include "Bench.h"
+#include "server/modules/Logger.h"
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+    // The Logger::log() body before the writer thread; localtime_r stands in for localtime, which was a race
+    void synchronousLog(const std::string &message)
+    {
+        auto timePoint = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        std::tm tm {};
+        localtime_r(&timePoint, &tm);
+
+        std::ostringstream logStream;
+        logStream << "\033[37m" << "[" << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << "] [INFO] " << message << "\033[0m";
+        std::cout << logStream.str() << std::endl;
+    }
+
+    // Points stdout at a temporary file for its lifetime, so the results can still be printed afterwards
+    class CapturedStdout {
+        FILE *m_File = std::tmpfile();
+        int m_Saved = dup(STDOUT_FILENO);
+
+    public:
+        CapturedStdout()
+        {
+            std::fflush(stdout);
+            dup2(fileno(m_File), STDOUT_FILENO);
+        }
+
+        ~CapturedStdout()
+        {
+            std::cout.flush();
+            std::fflush(stdout);
+            dup2(m_Saved, STDOUT_FILENO);
+            close(m_Saved);
+            std::fclose(m_File);
+        }
+
+        void truncate()
+        {
+            std::fflush(stdout);
+            ftruncate(fileno(m_File), 0);
+            lseek(fileno(m_File), 0, SEEK_SET);
+        }
+
+        // Benchmark lines written since the last truncate()
+        size_t countLines()
+        {
+            std::cout.flush();
+            std::fflush(stdout);
+            lseek(fileno(m_File), 0, SEEK_SET);
+
+            size_t lines = 0;
+            std::string pending;
+            char buffer[1 << 16];
+            ssize_t bytes;
+            while ((bytes = read(fileno(m_File), buffer, sizeof(buffer))) > 0)
+            {
+                pending.append(buffer, static_cast<size_t>(bytes));
+                size_t start = 0;
+                for (size_t end; (end = pending.find('\n', start)) != std::string::npos; start = end + 1)
+                    if (std::string_view(pending).substr(start, end - start).find("bench client") != std::string_view::npos)
+                        lines++;
+                pending.erase(0, start);
+            }
+            return lines;
+        }
+    };
+
+    template<typename Call>
+    void runThreads(size_t threads, size_t calls, Call &&call)
+    {
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; t++)
+        {
+            workers.emplace_back([&, t]
+            {
+                for (size_t i = t; i < calls; i += threads)
+                    call(i);
+            });
+        }
+        for (std::thread &worker : workers)
+            worker.join();
+    }
+
+    void report(const char *name, size_t threads, const bench::Result &result, size_t delivered, size_t calls)
+    {
+        bench::report(std::string(name) + ", " + std::to_string(threads) + " thread(s)", result);
+        std::printf("%-48s %11.1f%% of lines delivered\n", "", 100.0 * static_cast<double>(delivered) / static_cast<double>(calls));
+    }
+
+    void runLogger(const char *name, LogOverflow overflow, size_t threads)
+    {
+        size_t calls = bench::iterations(1'000'000);
+        bench::Result result;
+        size_t delivered;
+        {
+            CapturedStdout output;
+            LoggerConfig config;
+            config.overflow = overflow;
+            Logger logger(config);
+            logger.init();
+            logger.run();
+
+            // Each repetition is timed until the last line is written
+            result = bench::measure(calls, [&](size_t count)
+            {
+                output.truncate();
+                runThreads(threads, count, [](size_t i) { LOG_INFO("Bench", "bench client {} sent {} bytes", i, 512); });
+                Logger::flush();
+            }, 3);
+            delivered = output.countLines();
+        }
+        report(name, threads, result, delivered, calls);
+    }
+
+    void runSynchronous(size_t threads)
+    {
+        size_t calls = bench::iterations(1'000'000);
+        bench::Result result;
+        size_t delivered;
+        {
+            CapturedStdout output;
+            result = bench::measure(calls, [&](size_t count)
+            {
+                output.truncate();
+                runThreads(threads, count, [](size_t i)
+                {
+                    std::string message;
+                    formatTo(message, "bench client {} sent {} bytes", i, 512);
+                    synchronousLog(message);
+                });
+            }, 3);
+            delivered = output.countLines();
+        }
+        report("synchronous", threads, result, delivered, calls);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bench::init(argc, argv);
+    bench::header("Logger contention (ops are log calls across all threads)");
+
+    for (size_t threads : {1, 2, 4, 8})
+    {
+        runLogger("rings, drop", LogOverflow::Drop, threads);
+        runLogger("rings, block", LogOverflow::Block, threads);
+        runSynchronous(threads);
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+//
+// Created by msullivan on 12/19/24.
+//
+
+// Cost of looking up a module by type from 1 to 8 threads at once: ModuleManager::findModule<T>() and the
+// current getModule<T>() against the getModule<T>() they replaced (mutex, contains(), operator[] on the
+// type_index map and dynamic_pointer_cast), reproduced below over the same modules.
+
+#include "Bench.h"
+#include "server/ModuleManager.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+    template<int N>
+    struct BenchModule : ServerModule {
+        int value = N;
+        void init() override {}
+        void run() override {}
+        std::vector<std::type_index> requiredDependencies() const override { return {}; }
+        std::vector<std::type_index> optionalDependencies() const override { return {}; }
+    };
+
+    // Roughly as many modules as a server registers; lookups go to the last one
+    using Target = BenchModule<7>;
+
+    class PreviousLookup {
+        std::unordered_map<std::type_index, std::shared_ptr<ServerModule>> m_Modules;
+        std::mutex m_Mutex;
+
+    public:
+        template<typename T>
+        void add() { m_Modules[std::type_index(typeid(T))] = std::make_shared<T>(); }
+
+        template<typename T>
+        std::shared_ptr<T> getModule()
+        {
+            std::lock_guard lock(m_Mutex);
+            const auto type = std::type_index(typeid(T));
+            return m_Modules.contains(type) ? std::dynamic_pointer_cast<T>(m_Modules[type]) : nullptr;
+        }
+    };
+
+    template<typename Lookup>
+    bench::Result run(size_t threads, Lookup &&lookup)
+    {
+        return bench::measure(bench::iterations(10'000'000), [&](size_t count)
+        {
+            std::vector<std::thread> workers;
+            for (size_t t = 0; t < threads; t++)
+            {
+                workers.emplace_back([&]
+                {
+                    for (size_t i = 0; i < count / threads; i++)
+                        bench::doNotOptimize(lookup());
+                });
+            }
+            for (std::thread &worker : workers)
+                worker.join();
+        }, 3);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bench::init(argc, argv);
+    bench::header("Module lookup (ops are lookups across all threads)");
+
+    ModuleManager manager;
+    PreviousLookup previous;
+    [&]<int... N>(std::integer_sequence<int, N...>)
+    {
+        (manager.registerModule<BenchModule<N>>(), ...);
+        (previous.add<BenchModule<N>>(), ...);
+    }(std::make_integer_sequence<int, 8> {});
+    manager.freeze();
+
+    for (size_t threads : {1, 2, 4, 8})
+    {
+        std::string suffix = ", " + std::to_string(threads) + " thread(s)";
+        bench::report("findModule" + suffix, run(threads, [&] { return manager.findModule<Target>()->value; }));
+        bench::report("getModule" + suffix, run(threads, [&] { return manager.getModule<Target>()->value; }));
+        bench::report("previous getModule" + suffix, run(threads, [&] { return previous.getModule<Target>()->value; }));
+    }
+    return 0;
+}
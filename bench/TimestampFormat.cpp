@@ -0,0 +1,77 @@
+//
+// Created by msullivan on 12/19/24.
+//
+
+// Cost of formatting a log line's timestamp: TimestampCache against the localtime + put_time through an
+// ostringstream that Logger and Message::timestamp() used to do for every line. Timestamps are 1 us apart
+// (1M lines/s) or 1 ms apart (1k lines/s), so the cache's once-per-second strftime is included.
+
+#include "Bench.h"
+#include "common/Timestamp.h"
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+namespace {
+    using Clock = std::chrono::system_clock;
+
+    std::string streamTimestamp(Clock::time_point time)
+    {
+        auto timePoint = Clock::to_time_t(time);
+        std::tm tm = *std::localtime(&timePoint);
+
+        std::ostringstream timestampStream;
+        timestampStream << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
+        return timestampStream.str();
+    }
+
+    void report(const std::string &name, const bench::Result &result)
+    {
+        bench::report(name, result);
+        // What formatting alone costs a process logging a million lines a second
+        std::printf("%-48s %11.1f%% of a core at 1M lines/s\n", "", result.nanosecondsPerOp * 1e6 / 1e9 * 100);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bench::init(argc, argv);
+    bench::header("Timestamp formatting (ops are timestamps)");
+
+    const Clock::time_point start = Clock::now();
+    size_t count = bench::iterations(5'000'000);
+
+    for (auto [label, spacing] : {std::pair {"1 us apart", std::chrono::microseconds(1)},
+                                  std::pair {"1 ms apart", std::chrono::microseconds(1000)}})
+    {
+        std::string suffix = std::string(", ") + label;
+
+        auto stream = bench::measure(count, [&](size_t n)
+        {
+            Clock::time_point time = start;
+            for (size_t i = 0; i < n; i++, time += spacing)
+                bench::doNotOptimize(streamTimestamp(time));
+        }, 3);
+        report("localtime + put_time" + suffix, stream);
+
+        for (auto [name, precision] : {std::pair {"cache, seconds", TimestampPrecision::Seconds},
+                                       std::pair {"cache, milliseconds", TimestampPrecision::Milliseconds}})
+        {
+            auto cached = bench::measure(count, [&](size_t n)
+            {
+                TimestampCache cache;
+                std::string line;
+                Clock::time_point time = start;
+                for (size_t i = 0; i < n; i++, time += spacing)
+                {
+                    line.clear();
+                    cache.append(line, time, precision);
+                    bench::doNotOptimize(line.data());
+                }
+            });
+            report(name + suffix, cached);
+        }
+    }
+    return 0;
+}
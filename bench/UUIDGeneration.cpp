@@ -0,0 +1,85 @@
+//
+// Created by msullivan on 12/19/24.
+//
+
+// UUIDs per second per core: version 4 and version 7 UUIDs, bare and formatted, against the previous UUID
+// (a fresh random_device and mt19937 per UUID, formatted through an ostringstream), reproduced below. Each case
+// runs on one thread and then on one thread per core; rates are per core.
+
+#include "Bench.h"
+#include "common/UUID.h"
+#include <algorithm>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    std::string previousUUID()
+    {
+        unsigned char data[16];
+        std::random_device rd;
+        std::mt19937 mt(rd());
+        std::uniform_int_distribution<int> dist(0, 255);
+        for (size_t i = 0; i < 16; ++i)
+            data[i] = static_cast<unsigned char>(dist(mt));
+        data[6] = (data[6] & 0x0f) | 0x40;
+        data[8] = (data[8] & 0x3f) | 0x80;
+
+        std::ostringstream oss;
+        oss << std::hex << std::setfill('0');
+        for (size_t i = 0; i < 16; ++i)
+        {
+            oss << std::setw(2) << static_cast<int>(data[i]);
+            if (i == 3 || i == 5 || i == 7 || i == 9) oss << '-';
+        }
+        return oss.str();
+    }
+
+    template<typename Generate>
+    void run(const char *name, size_t count, Generate &&generate)
+    {
+        size_t cores = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t threads : {size_t(1), cores})
+        {
+            auto result = bench::measure(count * threads, [&](size_t total)
+            {
+                std::vector<std::thread> workers;
+                for (size_t t = 0; t < threads; t++)
+                {
+                    workers.emplace_back([&]
+                    {
+                        for (size_t i = 0; i < total / threads; i++)
+                            generate();
+                    });
+                }
+                for (std::thread &worker : workers)
+                    worker.join();
+            }, 3);
+
+            // Per core: with more threads than cores the extra ones only time-share
+            double perCore = result.opsPerSecond / static_cast<double>(std::min(threads, cores));
+            std::string label = name;
+            label.append(", ").append(std::to_string(threads)).append(" thread(s)");
+            bench::report(label, result);
+            std::printf("%-48s %12.2f M UUIDs/s per core\n", "", perCore / 1e6);
+            if (cores == 1) break;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bench::init(argc, argv);
+    bench::header("UUID generation (ops are UUIDs across all threads)");
+
+    size_t count = bench::iterations(10'000'000);
+    run("v4", count, [] { bench::doNotOptimize(UUID::v4()); });
+    run("v4, formatted", count, [] { bench::doNotOptimize(UUID::v4().toChars()); });
+    run("v7", count, [] { bench::doNotOptimize(UUID::v7()); });
+    run("v7, formatted", count, [] { bench::doNotOptimize(UUID::v7().toChars()); });
+    run("previous, formatted", count / 200, [] { bench::doNotOptimize(previousUUID()); });
+    return 0;
+}
@@ -5,6 +5,10 @@
 #pragma once
 #include "ServerModule.h"
 #include "server/Signal.h"
+#include "common/Frame.h"
+#include "common/Message.h"
+#include <memory_resource>
+#include <string_view>
 
 /* Components */
 struct ServerConnection;
@@ -14,7 +18,28 @@ struct ClientInfo;
 struct SocketInfo;
 struct Metrics;
 
+struct NetworkConfig {
+    int port = 8000;                // 0 lets the kernel pick a port
+    unsigned int workers = 0;       // I/O worker (reactor) threads; 0 means one per hardware thread
+    int backlog = 4096;             // Per-listener accept queue length (clamped by net.core.somaxconn)
+    size_t maxFrameSize = 1 << 20;  // Largest frame a client may send before it is disconnected
+    int idleTimeout = 30;           // Seconds without a frame (keepalives included) before a client is dropped; 0 never
+    int keepaliveTimeout = 60;      // Seconds before TCP keepalive declares a silent peer dead; 0 keeps the system default
+
+    size_t sendHighWatermark = 4 << 20;     // Queued bytes at which backpressure is raised for a connection
+    size_t sendLowWatermark = 1 << 20;      // Queued bytes at which backpressure is released again
+    int slowClientTimeout = 10;             // Seconds a client may stay above the high watermark; 0 never disconnects
+};
+
+struct AcceptStats {
+    size_t accepted = 0;            // Connections accepted since startup
+    size_t backlogOverflows = 0;    // Wakeups that found a listener's accept queue full
+    double acceptRate = 0;          // Connections accepted per second over the last reactor tick
+};
+
 class NetworkEngine : public ServerModule {
+    NetworkConfig m_Config;
+
 public signals:
     static Signal<> started;
     static Signal<> shutdown;
@@ -22,38 +47,53 @@ public signals:
     static Signal<Connection> clientDisconnected;
     static Signal<Connection, const std::string &> sentData;
     static Signal<Connection, const std::string &> receivedData;
-    static Signal<Connection, const std::string &> broadcastData;
+    static Signal<Connection, const Message &> broadcastData;   // The message lives in the reactor's frame arena
     static Signal<Connection> receivedKeepalive;
+    static Signal<Connection, bool> backpressure;   // true above the high watermark, false once below the low one
 
 public slots:
     static void onAccept(Connection);
     static void onDisconnect(Connection);
     static void onSentData(Connection, const std::string &);
     static void onReceivedData(Connection, const std::string &);
-    static void onReceivedBroadcast(Connection, const std::string &);
+    static void onReceivedBroadcast(Connection, const Message &);
     static void onReceivedKeepalive(Connection);
+    static void onBackpressure(Connection, bool);
 
 public:
+    explicit NetworkEngine(NetworkConfig config = {});
     ~NetworkEngine() override;
     void init() override;
     void run() override;
-    [[nodiscard]] std::vector<std::type_index> requiredDependencies() const override { return {}; }
+    [[nodiscard]] std::vector<std::type_index> requiredDependencies() const override;
     [[nodiscard]] std::vector<std::type_index> optionalDependencies() const override { return {}; }
 
     static Connection getServer();
     static std::vector<Connection> clients();
     static size_t size();
     static bool empty();
+    static AcceptStats acceptStats();
 
     static bool disconnect(Connection);
     static bool sendData(Connection sender, const std::string &);
-    static std::string receiveData(Connection);
-    static bool hasPendingData(Connection);
+    static bool sendData(Connection sender, SharedPayload);
+    static size_t broadcast(SharedPayload, Connection exclude = -1);
+    static std::vector<std::string> receiveData(Connection);
 
     static long getFD(Connection);
     static std::string getIP(Connection);
+
+    // "ip:port" of a connection, written into the caller's buffer; empty if the connection is gone
+    static constexpr size_t ADDRESS_LENGTH = 22;
+    static std::string_view getAddress(Connection, char (&buffer)[ADDRESS_LENGTH]);
+
+    // Scratch memory for the current batch of events on this reactor thread. It is released in bulk once
+    // the batch is handled, so nothing allocated from it may be kept past the slot call. On other threads
+    // this is the default heap resource.
+    static std::pmr::memory_resource *frameArena();
     static int getPort(Connection);
 
     static bool isActiveConnection(Connection, int timeout);
+    // Whether the connection is registered and not being disconnected; makes no syscall
     static bool isValidConnection(Connection);
 };
\ No newline at end of file
@@ -3,5 +3,63 @@
 //
 
 #pragma once
-#include "ServerModule.h"
-#include "NetworkEngine.h"
\ No newline at end of file
+#include <stddef.h>
+#include <stdint.h>
+
+// C ABI for modules built as shared libraries and loaded at runtime by ModuleLoader.
+//
+// A library exports one function named XSERVER_MODULE_ENTRY with the XServerModuleEntry signature. It is
+// called with the host's API version and returns a description of the module, or NULL if the module cannot
+// work with that host. The description must stay valid until the library is unloaded.
+//
+// Callbacks run on the server's I/O threads, concurrently for different connections, and must not block.
+// When a module is reloaded the new copy is created and published first; calls that are already in the old
+// copy finish before it is destroyed and its library is closed. Clients stay connected throughout.
+//
+// Compatibility: a host accepts modules of its own major version whose structs are at least as large as it
+// expects; members are only ever appended, and `size` tells the other side which ones exist.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define XSERVER_MODULE_API_VERSION 1
+#define XSERVER_MODULE_ENTRY "xserverModuleEntry"
+
+enum XServerLogLevel {
+    XSERVER_LOG_DEBUG,
+    XSERVER_LOG_INFO,
+    XSERVER_LOG_WARNING,
+    XSERVER_LOG_ERROR
+};
+
+// Services the server offers to a module; valid for the module instance's lifetime
+struct XServerHostAPI {
+    uint32_t version;       // XSERVER_MODULE_API_VERSION of the host
+    uint32_t size;          // sizeof(struct XServerHostAPI) of the host
+
+    void (*log)(enum XServerLogLevel level, const char *module, const char *message);
+    int (*send)(int connection, const char *data, size_t size);                 // Nonzero if the data was queued
+    size_t (*broadcast)(const char *data, size_t size, int excludeConnection);  // Returns the number of recipients
+    int (*disconnect)(int connection);                                          // Nonzero if it was connected
+};
+
+// A module. Event callbacks may be NULL.
+struct XServerModule {
+    uint32_t version;       // XSERVER_MODULE_API_VERSION the module was built against
+    uint32_t size;          // sizeof(struct XServerModule) the module was built against
+    const char *name;       // Unique among loaded modules; a reload must keep it
+
+    void *(*create)(const struct XServerHostAPI *host);     // Returns the instance, or NULL on failure
+    void (*destroy)(void *instance);
+
+    void (*onClientAccepted)(void *instance, int connection);
+    void (*onClientDisconnected)(void *instance, int connection);
+    void (*onReceivedData)(void *instance, int connection, const char *data, size_t size);
+};
+
+typedef const struct XServerModule *(*XServerModuleEntry)(uint32_t hostVersion);
+
+#ifdef __cplusplus
+}
+#endif
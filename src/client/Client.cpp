@@ -3,17 +3,24 @@
 //
 
 #include "Client.h"
+#include "common/Timestamp.h"
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
 
 void printUsage();
 
 Client::Client() : m_Running(true)
-{}
+{
+    m_LoopThread = std::thread([this] { m_Loop.run(); });
+}
 
 Client::~Client()
 {
-    // Delete the connection to server (if any)
-    if (!m_Connection)
-        delete m_Connection;
+    m_Loop.post([this] { m_Connection.reset(); });
+    m_Loop.stop();
+    if (m_LoopThread.joinable())
+        m_LoopThread.join();
 }
 
 Client &Client::instance()
@@ -26,7 +33,6 @@ int Client::init(int argc, char **argv)
 {
     std::string serverIP;
     int serverPort = -1;
-    std::string username;
 
     int opt;
     while ((opt = getopt(argc, argv, "i:p:h")) != -1)
@@ -48,6 +54,9 @@ int Client::init(int argc, char **argv)
                 return 1;
         }
     }
+
+    if (!serverIP.empty() && serverPort > 0)
+        connectToServer(serverIP, serverPort, 5);
     return 0;
 }
 
@@ -59,9 +68,7 @@ int Client::run(int argc, char **argv)
     if (result != 0) return result;
 
     std::string input;
-    while (m_Running) {
-        std::getline(std::cin, input);
-
+    while (m_Running && std::getline(std::cin, input)) {
         if (input.empty()) {
             // Do nothing.
         }
@@ -76,17 +83,13 @@ int Client::run(int argc, char **argv)
             std::cout << ss.str() << '\n';
         }
         else if (input == "/info") {
-            if (m_Connection != nullptr) {
-                std::cout << "Connected to " << m_Connection->ip() << ':' << m_Connection->port() << '\n';
-            } else {
-                std::cout << "There is no current server connection\n";
-            }
+            printInfo();
         }
-        else if (input.substr(0, 8) == "/connect") {
+        else if (input.starts_with("/connect")) {
             std::istringstream iss(input);
             std::string command;
             std::string newIP;
-            int newPort;
+            int newPort = -1;
 
             iss >> command >> newIP >> newPort;
 
@@ -94,24 +97,19 @@ int Client::run(int argc, char **argv)
                 std::cout << "Invalid IP or port for connection. Usage: /connect <ip> <port>\n";
                 continue;
             }
-            // Close current connection
-            if (m_Connection != nullptr)
-                m_Connection->closeConnection();
             connectToServer(newIP, newPort, 5);
         }
-        else if (input == "/connect") {
-            if (m_Connection != nullptr)
-                m_Connection->closeConnection();
+        else if (input == "/disconnect") {
+            disconnect();
         }
         else if (input == "/quit")
             stop();
         else if (input == "/stop") {
             std::cout << "Telling the server to stop and disconnecting...\n";
             sendMessage(input);
-            if (m_Connection != nullptr)
-                m_Connection->closeConnection();
+            disconnect();
         }
-        else if (!input.empty()) {
+        else {
             sendMessage(input);  // Send the message to the server
         }
     }
@@ -121,112 +119,78 @@ int Client::run(int argc, char **argv)
 void Client::stop()
 {
     std::cout << "Quitting...\n";
-    if (m_Connection != nullptr)
-        m_Connection->closeConnection();
+    disconnect();
     m_Running = false;
 }
 
-bool Client::connectToServer(const std::string &ip, int port, int timeout)
+void Client::connectToServer(const std::string &ip, int port, int timeout)
 {
-    logMessage(LogLevel::Info, "Attempting to connect to server @ " + ip + ':' + std::to_string(port));
-
-    // 1. Create connection
-    m_Connection = new ClientConnection();
-
-    // 1.1 Create socket
-    if (!m_Connection->createSocket() || !m_Connection->createAddress(ip, port)) {
-        std::cerr << "Failed to create socket or address\n";
-        delete m_Connection;
-        m_Connection = nullptr;
-        return false;
-    }
-
-    // 4. Attempt to connectSignal to server
-    if (m_Connection->connectToServer() < 0) {
-        std::cerr << "Failed to connectSignal to server (" << m_Connection->ip() << ':' << m_Connection->port() << ")\n";
-        delete m_Connection;
-        m_Connection = nullptr;
-        return false;
-    }
-
-    // Start message listening thread
-    m_Connection->startMessagePollingThread();
-
-    // Start keepalive thread
-    m_Connection->startKeepaliveThread();
-
-    std::cout << "\nSuccessfully connected to server (" << m_Connection->ip() << ':' << m_Connection->port() << ")\n";
-    return true;
+    m_Loop.post([this, ip, port, timeout]
+    {
+        std::cout << "Attempting to connect to server @ " << ip << ':' << port << '\n';
 
-    // Start authentication
-    std::cout << "Starting authentication process...\n";
-    if (!authenticate()) {
-        std::cout << "Authentication failed; disconnecting...\n";
-        delete m_Connection;
-        m_Connection = nullptr;
-        return false;
-    }
-    std::cout << "Successfully authenticated with server\n";
+        // The previous connection's handlers may be on the stack if this came from one of them, so it is
+        // closed here and destroyed on a later turn of the loop
+        if (m_Connection)
+        {
+            m_Connection->close();
+            m_Loop.post([connection = std::shared_ptr<ClientConnection>(std::move(m_Connection))] {});
+        }
 
-    // Start message listening thread
-    //startMessagePollingThread();
+        m_Connection = std::make_unique<ClientConnection>(m_Loop);
+        ClientConnection *connection = m_Connection.get();
+        connection->onConnect([connection](bool connected)
+        {
+            if (connected)
+                std::cout << "\nSuccessfully connected to server (" << connection->ip() << ':' << connection->port() << ")\n";
+        });
+        connection->onMessage([](const MessageView &message)
+        {
+            if (message.timestamp == 0)
+            {
+                std::cout << "\aReceived: \"" << message.content << "\"\n";
+                return;
+            }
+            static TimestampCache timestamps("%H:%M:%S");
+            std::cout << "\aReceived [" << timestamps.format(message.time()) << "]: \"" << message.content << "\"\n";
+        });
+        connection->onDisconnect([connection]
+        {
+            std::cout << "Server (" << connection->ip() << ':' << connection->port() << ") closed the connection\n";
+        });
 
-    // Start keepalive thread
-    //startKeepaliveThread();
-    return true;
+        connection->connect(ip, port, std::chrono::seconds(timeout));
+    });
 }
 
-bool Client::authenticate()
+void Client::disconnect()
 {
-    // 1. Receive authentication prompt from the server
-    std::string prompt = receiveMessage();
-    if (prompt.empty()) {
-        std::cerr << "Failed to receive server prompt\n";
-        return false;
-    }
-    std::cout << prompt << '\n';
-
-    // 2. Prompt user to provide username
-    std::string username;
-    std::cout << "Username: ";
-    std::getline(std::cin, username);
-
-    // 3. Send username to the server
-    sendMessage(username);
-
-    // 4. Receive the server's response
-    std::string serverResponse = receiveMessage();
-    if (serverResponse.empty()) {
-        std::cerr << "Failed to receive server response\n";
-        return false;
-    }
-
-    std::cout << serverResponse << '\n';
-
-    // 5. Check if authentication was successful
-    if (serverResponse.find("Authentication successful") != std::string::npos) {
-        // Successful authentication
-        m_Username = username;
-
-        // Confirm that you acknowledge the server's authentication
-        sendMessage("OK");
-        return true;
-    } else {
-        // Authentication failed
-        return false;
-    }
+    m_Loop.post([this]
+    {
+        if (!m_Connection || m_Connection->state() == ClientConnection::State::Disconnected) return;
+        std::cout << "Closing connection to " << m_Connection->ip() << ':' << m_Connection->port() << '\n';
+        m_Connection->close();
+    });
 }
 
-bool Client::sendMessage(const std::string &message) const {
-    if (m_Connection != nullptr)
-        return m_Connection->sendData(message);
-    return false;
+void Client::sendMessage(const std::string &message)
+{
+    m_Loop.post([this, message]
+    {
+        if (!m_Connection || !m_Connection->send(message))
+            std::cout << "Not connected to a server (try /connect <ip> <port>)\n";
+    });
 }
 
-std::string Client::receiveMessage() const {
-    if (m_Connection != nullptr)
-        return m_Connection->receiveMessage();
-    return "";
+void Client::printInfo()
+{
+    m_Loop.post([this]
+    {
+        if (m_Connection && m_Connection->isConnected())
+            std::cout << "Connected to " << m_Connection->ip() << ':' << m_Connection->port() << '\n';
+        else
+            std::cout << "There is no current server connection\n";
+    });
 }
 
 void printUsage()
@@ -235,4 +199,4 @@ void printUsage()
     std::cout << "  -i ip          Specify the server's ip address" << std::endl;
     std::cout << "  -p port        Specify the port number" << std::endl;
     std::cout << "  -h             Display this help message" << std::endl;
-}
\ No newline at end of file
+}
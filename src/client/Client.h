@@ -4,10 +4,11 @@
 
 #pragma once
 #include "ClientConnection.h"
+#include "EventLoop.h"
 #include <string>
 #include <thread>
 #include <atomic>
-#include <mutex>
+#include <memory>
 
 class Client {
     Client();
@@ -25,8 +26,9 @@ public:
 
 private:
     std::atomic<bool> m_Running;
-    ClientConnection *m_Connection = nullptr;
-    std::string m_Username;
+    EventLoop m_Loop;                                   // Runs every connection; the main thread only reads input
+    std::thread m_LoopThread;
+    std::unique_ptr<ClientConnection> m_Connection;     // Only touched on the loop's thread
 
 public:
     // Runtime
@@ -34,11 +36,9 @@ public:
     int run(int argc, char **argv);
     void stop();
 
-    // Server connection
-    bool connectToServer(const std::string &ip, int port, int timeout);
-    [[nodiscard]] bool sendMessage(const std::string &message) const;
-    [[nodiscard]] std::string receiveMessage() const;
-
-    // User authentication
-    bool authenticate();
-};
\ No newline at end of file
+    // Server connection. These hand the work to the event loop and return straight away; the outcome is printed.
+    void connectToServer(const std::string &ip, int port, int timeout);
+    void disconnect();
+    void sendMessage(const std::string &message);
+    void printInfo();
+};
@@ -3,207 +3,257 @@
 //
 
 #include "ClientConnection.h"
-#include "common/PCH.h"
-
-#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <iostream>
 #include <arpa/inet.h>
-#include <poll.h>
-#else
-#include <winsock2.h>
-#include <ws2tcpip.h>
-#endif
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+    constexpr std::string_view KEEPALIVE_MESSAGE = "KEEPALIVE";
+    constexpr size_t READ_SIZE = 64 * 1024;
+}
 
+ClientConnection::ClientConnection(EventLoop &loop) : m_Loop(loop)
+{}
 
 ClientConnection::~ClientConnection()
 {
-    if (m_FD != -1)
-    {
-        shutdown(m_FD, SHUT_RDWR);
-        close(m_FD);
-    }
-    stopKeepaliveThread();
-    stopMessagePollingThread();
+    close();
 }
 
-bool ClientConnection::createAddress(const std::string& ip, int port)
+bool ClientConnection::connect(const std::string &ip, int port, std::chrono::milliseconds timeout)
 {
-    m_Address.sin_family = AF_INET;         // Use IPv4
-    m_Address.sin_port = htons(port);       // Bind port
+    close();
 
-    // Convert IP address from string to socket address
-    if (inet_pton(AF_INET, ip.c_str(), &m_Address.sin_addr) <= 0) {
-        logMessage(LogLevel::Error, "Failed to convert IP address from string");
+    m_Address = {};
+    m_Address.sin_family = AF_INET;
+    m_Address.sin_port = htons(port);
+    if (inet_pton(AF_INET, ip.c_str(), &m_Address.sin_addr) <= 0)
+    {
+        std::cerr << "Invalid IP address: " << ip << '\n';
         return false;
     }
-    return true;
-}
 
-int ClientConnection::connectToServer()
-{
-    // Attempt to connect
-    int connectionResult = connect(m_FD, reinterpret_cast<sockaddr *>(&m_Address), sizeof(m_Address));
+    m_FD = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_FD == -1)
+    {
+        std::cerr << "Failed to create socket: " << std::strerror(errno) << '\n';
+        return false;
+    }
+    int noDelay = 1;
+    setsockopt(m_FD, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
 
-    // Immediately return if successful
-    if (connectionResult == 0) {
-        logMessage(LogLevel::Info, "Connection successful");
-        return 1;
+    int result = ::connect(m_FD, reinterpret_cast<sockaddr *>(&m_Address), sizeof(m_Address));
+    if (result == -1 && errno != EINPROGRESS)
+    {
+        std::cerr << "Failed to connect to " << ip << ':' << port << ": " << std::strerror(errno) << '\n';
+        ::close(m_FD);
+        m_FD = -1;
+        return false;
     }
 
-    // Handle errors
-    if (connectionResult == -1) {
-        // Handle errors or retry based on the errno
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-            // No pending connections, can retry after a short delay or poll
-            std::cout << "No incoming connections right now\n";
-            logMessage(LogLevel::Error, "No incoming connections right now");
-            return -1;
-        }
-        else if (errno == EINTR) {
-            // Interrupted by signal, retry
-            logMessage(LogLevel::Error, "Interrupted by a signal");
-            return -1;
-        }
-        else if (errno == ECONNREFUSED) {
-            logMessage(LogLevel::Error, "Connection refused");
-            return -1;
-        }
-        else if (errno == ECONNABORTED) {
-            logMessage(LogLevel::Error, "Connection aborted");
-            return -1;
-        }
+    // Writability signals the end of the connect either way; finishConnect() tells success from failure
+    if (!m_Loop.watch(m_FD, EPOLLOUT, [this](uint32_t events) { handleEvents(events); }))
+    {
+        std::cerr << "Failed to watch socket: " << std::strerror(errno) << '\n';
+        ::close(m_FD);
+        m_FD = -1;
+        return false;
     }
 
-    // If connection is in progress, use poll to wait for it
-    if (connectionResult == -1 && errno == EINPROGRESS) {
-        pollfd pfd {};
-        pfd.fd = m_FD;
-        pfd.events = POLLOUT; // We are waiting for the socket to become writable (i.e., connected)
-        pfd.revents = 0;
+    m_State = State::Connecting;
+    m_ConnectTimer = m_Loop.addTimer(timeout, [this]
+    {
+        m_ConnectTimer = 0;
+        failConnect("timed out");
+    });
+    return true;
+}
 
-        int result = poll(&pfd, 1, 15000); // 30-second timeout
-        logMessage(LogLevel::Debug, "Poll result: " + std::to_string(result));
+bool ClientConnection::send(std::string_view payload)
+{
+    if (m_State != State::Connected) return false;
 
-        if (result <= 0) {
-            logMessage(LogLevel::Error, "Connection timed out or poll failed");
-            return 0;
-        }
+    size_t offset = m_WriteBuffer.size();
+    m_WriteBuffer.resize(offset + FRAME_HEADER_SIZE + payload.size());
+    writeFrameHeader(m_WriteBuffer.data() + offset, static_cast<uint32_t>(payload.size()));
+    std::memcpy(m_WriteBuffer.data() + offset + FRAME_HEADER_SIZE, payload.data(), payload.size());
+    m_LastSend = EventLoop::Clock::now();
 
-        // If poll() succeeds, check if the connection was successful
-        if (pfd.revents & POLLOUT) {
-            // Check if the socket is writable (connection is completed)
-            int socketError = 0;
-            socklen_t len = sizeof(socketError);
-            if (getsockopt(m_FD, SOL_SOCKET, SO_ERROR, &socketError, &len) == -1) {
-                logMessage(LogLevel::Error, "Failed to check socket error after poll");
-                return -2;
-            }
-
-            // Connection failed for another reason
-            if (socketError != 0) {
-                logMessage(LogLevel::Error, "Connection failed: " + socketError);
-
-                return -3;
-            }
-            return 1;
-        }
-    }
-    logMessage(LogLevel::ERROR, "Failed to connect to server: error " + std::to_string(errno));
-    return -1;
+    // Only the first frame of a burst writes straight away; the rest wait for EPOLLOUT behind it
+    if (offset == m_WriteOffset) return flush();
+    return true;
 }
 
-void ClientConnection::closeConnection()
+void ClientConnection::close()
 {
-    if (m_FD != -1) {
-        logMessage(LogLevel::Info, "Closing connection to " + ip() + ':' + std::to_string(port()));
+    if (m_ConnectTimer) m_Loop.cancelTimer(m_ConnectTimer);
+    if (m_KeepaliveTimer) m_Loop.cancelTimer(m_KeepaliveTimer);
+    m_ConnectTimer = m_KeepaliveTimer = 0;
 
-        close(m_FD);
+    if (m_FD != -1)
+    {
+        m_Loop.unwatch(m_FD);
+        ::close(m_FD);
         m_FD = -1;
     }
-    stopMessagePollingThread();
-    stopKeepaliveThread();
+
+    m_State = State::Disconnected;
+    m_ReadBuffer = {};
+    m_WriteBuffer.clear();
+    m_WriteOffset = 0;
 }
 
+void ClientConnection::handleEvents(uint32_t events)
+{
+    if (m_State == State::Connecting)
+    {
+        finishConnect();
+        return;
+    }
+
+    if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+    {
+        readFrames();
+        if (m_State != State::Connected) return;
+    }
+    if (events & EPOLLOUT) flush();
+}
 
-std::string ClientConnection::receiveMessage() const
+void ClientConnection::finishConnect()
 {
-    char buffer[1024];
-    ssize_t bytesReceived = recv(m_FD, buffer, sizeof(buffer), 0);
-    if (bytesReceived > 0) {
-        return std::string(buffer, bytesReceived);
-    } else if (bytesReceived == 0) {
-        std::cerr << "Connection closed by peer\n";
-        return "";
-    } else {
-        std::cerr << "Error receiving message\n";
-        return "";
+    int socketError = 0;
+    socklen_t length = sizeof(socketError);
+    if (getsockopt(m_FD, SOL_SOCKET, SO_ERROR, &socketError, &length) == -1) socketError = errno;
+    if (socketError != 0)
+    {
+        failConnect(std::strerror(socketError));
+        return;
     }
+
+    m_Loop.cancelTimer(m_ConnectTimer);
+    m_ConnectTimer = 0;
+    m_Loop.modify(m_FD, EPOLLIN | EPOLLRDHUP);
+    m_State = State::Connected;
+    m_LastSend = EventLoop::Clock::now();
+    scheduleKeepalive(m_KeepaliveInterval);
+
+    if (m_OnConnect) m_OnConnect(true);
 }
 
-void ClientConnection::startMessagePollingThread() {
-    m_MessagePolling = true;
-    m_MessagePollingThread = std::thread([this] {
-        // Initialize pollfd
-        pollfd pfd {};
-
-        while (m_MessagePolling) {
-            //logMessage(LogLevel::DEBUG, "Polling...");
-            pfd.fd = m_FD;       // Set the file descriptor
-            pfd.events = POLLIN;       // Make it poll signalManager
-            pfd.revents = 0;           // Initialize the signalManager to 0
-
-            int result = poll(&pfd, 1, 1000);  // Poll for 1 second
-
-            if (result == -1) {
-                logMessage(LogLevel::Error, "Poll failed: " + std::string(strerror(errno)));
-                return;
-            }
-
-            if (pfd.revents & POLLIN) {
-                std::string message = receiveMessage();
-                logMessage(LogLevel::Info, "\aReceived: \"" + message + '\"');
-                if (message.empty())
-                {
-                    logMessage(LogLevel::Info,
-                               "Client (" + ip() + ':' + std::to_string(port()) + ")'s connection reset (disconnected)");
-                    closeConnection();
-                }
-            }
-            std::this_thread::sleep_for(std::chrono::milliseconds(m_MessagePollingInterval));
-        }
-    });
+void ClientConnection::failConnect(const std::string &reason)
+{
+    std::cerr << "Failed to connect to " << ip() << ':' << port() << ": " << reason << '\n';
+    close();
+    if (m_OnConnect) m_OnConnect(false);
 }
 
-void ClientConnection::stopMessagePollingThread() {
-    m_MessagePolling = false;
-    if (m_MessagePollingThread.joinable()) {
-        m_MessagePollingThread.join();  // Wait for the thread to finish before cleaning up
+void ClientConnection::readFrames()
+{
+    while (true)
+    {
+        std::span<char> space = m_ReadBuffer.prepare(READ_SIZE);
+        ssize_t bytes = recv(m_FD, space.data(), space.size(), 0);
+        if (bytes == -1 && errno == EINTR) continue;
+        if (bytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (bytes <= 0)
+        {
+            drop();
+            return;
+        }
+        m_ReadBuffer.commit(bytes);
+
+        std::string_view payload;
+        FrameBuffer::Status status;
+        while ((status = m_ReadBuffer.next(payload)) == FrameBuffer::Status::Frame)
+        {
+            MessageView message;
+            if (!decodeMessage(payload, message))
+                message = {0, 0, payload};
+            if (m_OnMessage) m_OnMessage(message);
+            if (m_State != State::Connected) return;    // The handler closed the connection
+        }
+        if (status == FrameBuffer::Status::TooLarge)
+        {
+            std::cerr << "Server sent a frame larger than " << DEFAULT_MAX_FRAME_SIZE << " bytes\n";
+            drop();
+            return;
+        }
+
+        // A short read means the socket is drained; skip the recv() that would only return EAGAIN
+        if (static_cast<size_t>(bytes) < space.size()) return;
     }
 }
 
-void ClientConnection::startKeepaliveThread()
+bool ClientConnection::flush()
 {
-    m_KeepaliveRunning = true;
-    m_KeepaliveThread = std::thread([this] {
-        logMessage(LogLevel::Debug, "Started keepalive thread");
-        while (m_KeepaliveRunning)
+    while (m_WriteOffset < m_WriteBuffer.size())
+    {
+        ssize_t bytes = ::send(m_FD, m_WriteBuffer.data() + m_WriteOffset, m_WriteBuffer.size() - m_WriteOffset,
+                               MSG_NOSIGNAL);
+        if (bytes == -1 && errno == EINTR) continue;
+        if (bytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
         {
-            if (m_FD != -1) {
-                //logMessage(LogLevel::DEBUG, "Sending keepalive message...");
-                std::string keepaliveMessage = "KEEPALIVE";
-                if (!keepaliveMessage.empty())
-                    sendData("KEEPALIVE");
-            }
-            std::this_thread::sleep_for(std::chrono::seconds(m_KeepaliveInterval));
+            // Resume once the socket drains
+            m_Loop.modify(m_FD, EPOLLIN | EPOLLOUT | EPOLLRDHUP);
+            return true;
         }
-    });
+        if (bytes == -1)
+        {
+            drop();
+            return false;
+        }
+        m_WriteOffset += bytes;
+    }
+
+    if (!m_WriteBuffer.empty())
+    {
+        m_WriteBuffer.clear();
+        m_WriteOffset = 0;
+        m_Loop.modify(m_FD, EPOLLIN | EPOLLRDHUP);
+    }
+    return true;
 }
 
+void ClientConnection::scheduleKeepalive(EventLoop::Clock::duration delay)
+{
+    m_KeepaliveTimer = m_Loop.addTimer(delay, [this]
+    {
+        m_KeepaliveTimer = 0;
+        sendKeepalive();
+    });
+}
 
-void ClientConnection::stopKeepaliveThread()
+void ClientConnection::sendKeepalive()
 {
-    m_KeepaliveRunning = false;
-    if (m_KeepaliveThread.joinable()) {
-        m_KeepaliveThread.join();  // Wait for the thread to finish before cleaning up
+    // Any frame proves the client is alive, so only an idle connection needs a keepalive
+    EventLoop::Clock::duration idle = EventLoop::Clock::now() - m_LastSend;
+    if (idle >= m_KeepaliveInterval)
+    {
+        if (!send(KEEPALIVE_MESSAGE)) return;
+        idle = {};
     }
-    logMessage(LogLevel::Debug, "Stopped keepalive thread");
-}
\ No newline at end of file
+    scheduleKeepalive(m_KeepaliveInterval - idle);
+}
+
+void ClientConnection::drop()
+{
+    close();
+    if (m_OnDisconnect) m_OnDisconnect();
+}
+
+std::string ClientConnection::ip() const
+{
+    char text[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &m_Address.sin_addr, text, sizeof(text));
+    return text;
+}
+
+int ClientConnection::port() const
+{
+    return ntohs(m_Address.sin_port);
+}
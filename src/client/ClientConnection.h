@@ -3,34 +3,81 @@
 //
 
 #pragma once
-#include "common/Connection.h"
-#include <thread>
-#include <atomic>
+#include "EventLoop.h"
+#include "common/Frame.h"
+#include "common/Message.h"
+#include <chrono>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <netinet/in.h>
 
-class ClientConnection : public OldConnection {
+// A framed connection to the server driven by an EventLoop. Connecting, receiving and keepalives are all
+// readiness- or timer-driven, so a connection costs a socket and a timer rather than threads.
+//
+// All members must be called on the loop's thread. Callbacks run there too; a callback may close() the connection
+// but must not destroy it (post the deletion to the loop instead).
+class ClientConnection {
 public:
-    ClientConnection() = default;
-    ~ClientConnection() override;
+    enum class State { Disconnected, Connecting, Connected };
+
+    using ConnectHandler = std::function<void(bool connected)>;
+    // Broadcasts arrive decoded; plain-text replies from the server come with a sender id and timestamp of 0
+    using MessageHandler = std::function<void(const MessageView &message)>;
+    using DisconnectHandler = std::function<void()>;
 
 private:
-    std::atomic<bool> m_KeepaliveRunning;
-    std::thread m_KeepaliveThread;
-    int m_KeepaliveInterval = 15;
+    EventLoop &m_Loop;
+    int m_FD = -1;
+    sockaddr_in m_Address {};
+    State m_State = State::Disconnected;
+
+    FrameBuffer m_ReadBuffer;
+    std::string m_WriteBuffer;          // Frames the socket hasn't taken yet
+    size_t m_WriteOffset = 0;           // Bytes of m_WriteBuffer already sent
+
+    std::chrono::seconds m_KeepaliveInterval {15};
+    EventLoop::Clock::time_point m_LastSend;
+    EventLoop::TimerID m_KeepaliveTimer = 0;
+    EventLoop::TimerID m_ConnectTimer = 0;
 
-    std::atomic<bool> m_MessagePolling;
-    std::thread m_MessagePollingThread;
-    int m_MessagePollingInterval = 100;
+    ConnectHandler m_OnConnect;
+    MessageHandler m_OnMessage;
+    DisconnectHandler m_OnDisconnect;
+
+    void handleEvents(uint32_t events);
+    void finishConnect();
+    void failConnect(const std::string &reason);
+    void readFrames();
+    bool flush();
+    void scheduleKeepalive(EventLoop::Clock::duration delay);
+    void sendKeepalive();
+    void drop();
 
 public:
-    bool createAddress(const std::string &ip, int port);
-    int connectToServer();
-    void closeConnection();
+    explicit ClientConnection(EventLoop &loop);
+    ~ClientConnection();
+    ClientConnection(const ClientConnection &) = delete;
+    ClientConnection &operator=(const ClientConnection &) = delete;
+
+    // Starts connecting; the connect handler reports the outcome. Returns false if the attempt couldn't start.
+    bool connect(const std::string &ip, int port, std::chrono::milliseconds timeout);
+
+    // Queues payload as one frame; returns false if not connected
+    bool send(std::string_view payload);
+
+    // Closes the socket without calling the disconnect handler
+    void close();
 
-    void startMessagePollingThread();
-    void stopMessagePollingThread();
+    void onConnect(ConnectHandler handler) { m_OnConnect = std::move(handler); }
+    void onMessage(MessageHandler handler) { m_OnMessage = std::move(handler); }
+    void onDisconnect(DisconnectHandler handler) { m_OnDisconnect = std::move(handler); }
 
-    void startKeepaliveThread();
-    void stopKeepaliveThread();
+    // A keepalive is sent after this long without other traffic; applies from the next one on
+    void setKeepaliveInterval(std::chrono::seconds interval) { m_KeepaliveInterval = interval; }
 
-    [[nodiscard]] std::string receiveMessage() const;
-};
\ No newline at end of file
+    [[nodiscard]] State state() const { return m_State; }
+    [[nodiscard]] bool isConnected() const { return m_State == State::Connected; }
+    [[nodiscard]] std::string ip() const;
+    [[nodiscard]] int port() const;
+};
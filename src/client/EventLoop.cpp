@@ -0,0 +1,164 @@
+//
+// Created by msullivan on 12/18/24.
+//
+
+#include "EventLoop.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace {
+    constexpr int MAX_EVENTS = 256;
+}
+
+EventLoop::EventLoop()
+{
+    m_EpollFD = epoll_create1(EPOLL_CLOEXEC);
+    m_WakeFD = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_EpollFD == -1 || m_WakeFD == -1)
+    {
+        std::cerr << "Failed to create event loop: " << std::strerror(errno) << '\n';
+        return;
+    }
+
+    epoll_event event {};
+    event.events = EPOLLIN;
+    event.data.fd = m_WakeFD;
+    epoll_ctl(m_EpollFD, EPOLL_CTL_ADD, m_WakeFD, &event);
+}
+
+EventLoop::~EventLoop()
+{
+    if (m_WakeFD != -1) close(m_WakeFD);
+    if (m_EpollFD != -1) close(m_EpollFD);
+}
+
+bool EventLoop::watch(int fd, uint32_t events, IOHandler handler)
+{
+    epoll_event event {};
+    event.events = events;
+    event.data.fd = fd;
+    if (epoll_ctl(m_EpollFD, EPOLL_CTL_ADD, fd, &event) == -1) return false;
+
+    m_Handlers[fd] = std::make_shared<IOHandler>(std::move(handler));
+    return true;
+}
+
+bool EventLoop::modify(int fd, uint32_t events)
+{
+    epoll_event event {};
+    event.events = events;
+    event.data.fd = fd;
+    return epoll_ctl(m_EpollFD, EPOLL_CTL_MOD, fd, &event) == 0;
+}
+
+void EventLoop::unwatch(int fd)
+{
+    if (m_Handlers.erase(fd) == 0) return;
+    epoll_ctl(m_EpollFD, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+EventLoop::TimerID EventLoop::addTimer(Clock::duration delay, Task task)
+{
+    TimerID id = m_NextTimer++;
+    Clock::time_point deadline = Clock::now() + delay;
+    m_Timers.emplace(std::pair(deadline, id), std::move(task));
+    m_TimerDeadlines.emplace(id, deadline);
+    return id;
+}
+
+bool EventLoop::cancelTimer(TimerID id)
+{
+    auto it = m_TimerDeadlines.find(id);
+    if (it == m_TimerDeadlines.end()) return false;
+
+    m_Timers.erase(std::pair(it->second, id));
+    m_TimerDeadlines.erase(it);
+    return true;
+}
+
+void EventLoop::post(Task task)
+{
+    {
+        std::lock_guard lock(m_PostedMutex);
+        m_Posted.push_back(std::move(task));
+    }
+    uint64_t one = 1;
+    [[maybe_unused]] ssize_t written = write(m_WakeFD, &one, sizeof(one));
+}
+
+void EventLoop::run()
+{
+    epoll_event events[MAX_EVENTS];
+
+    while (!m_Stopped)
+    {
+        int count = epoll_wait(m_EpollFD, events, MAX_EVENTS, nextTimeout());
+        if (count == -1 && errno != EINTR)
+        {
+            std::cerr << "epoll_wait() failed: " << std::strerror(errno) << '\n';
+            break;
+        }
+
+        for (int i = 0; i < count && !m_Stopped; i++)
+        {
+            int fd = events[i].data.fd;
+            if (fd == m_WakeFD)
+            {
+                uint64_t value;
+                [[maybe_unused]] ssize_t bytes = read(m_WakeFD, &value, sizeof(value));
+                continue;
+            }
+
+            // An earlier callback in this batch may have unwatched the descriptor
+            auto it = m_Handlers.find(fd);
+            if (it == m_Handlers.end()) continue;
+            std::shared_ptr<IOHandler> handler = it->second;
+            (*handler)(events[i].events);
+        }
+
+        runPosted();
+        runTimers();
+    }
+}
+
+void EventLoop::stop()
+{
+    m_Stopped = true;
+    post([] {});
+}
+
+int EventLoop::nextTimeout() const
+{
+    if (m_Timers.empty()) return -1;
+
+    // Round up, so the loop doesn't wake just short of the deadline and spin with a timeout of 0
+    auto remaining = m_Timers.begin()->first.first - Clock::now();
+    if (remaining <= Clock::duration::zero()) return 0;
+    return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(remaining).count());
+}
+
+void EventLoop::runTimers()
+{
+    Clock::time_point now = Clock::now();
+    while (!m_Timers.empty() && m_Timers.begin()->first.first <= now && !m_Stopped)
+    {
+        auto node = m_Timers.extract(m_Timers.begin());
+        m_TimerDeadlines.erase(node.key().second);
+        node.mapped()();
+    }
+}
+
+void EventLoop::runPosted()
+{
+    std::vector<Task> tasks;
+    {
+        std::lock_guard lock(m_PostedMutex);
+        tasks.swap(m_Posted);
+    }
+    for (Task &task : tasks)
+        task();
+}
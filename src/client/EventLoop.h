@@ -0,0 +1,73 @@
+//
+// Created by msullivan on 12/18/24.
+//
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Single-threaded reactor for the client: socket readiness callbacks, timers and tasks posted from other threads
+// all run on the thread that calls run(), so one thread can host any number of ClientConnections.
+//
+// Everything other than post() and stop() must be called on the loop's thread, or before run() starts.
+class EventLoop {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Task = std::function<void()>;
+    using IOHandler = std::function<void(uint32_t events)>;    // Receives the epoll event mask
+    using TimerID = uint64_t;
+
+private:
+    int m_EpollFD = -1;
+    int m_WakeFD = -1;                  // eventfd that interrupts epoll_wait() when a task is posted
+    std::atomic<bool> m_Stopped {false};
+
+    // Held by shared_ptr so a handler can unwatch its own descriptor while it runs
+    std::unordered_map<int, std::shared_ptr<IOHandler>> m_Handlers;
+
+    // Ordered by deadline; the ID breaks ties, so timers with the same deadline fire in the order they were added
+    std::map<std::pair<Clock::time_point, TimerID>, Task> m_Timers;
+    std::unordered_map<TimerID, Clock::time_point> m_TimerDeadlines;
+    TimerID m_NextTimer = 1;
+
+    std::mutex m_PostedMutex;
+    std::vector<Task> m_Posted;
+
+    [[nodiscard]] int nextTimeout() const;
+    void runTimers();
+    void runPosted();
+
+public:
+    EventLoop();
+    ~EventLoop();
+    EventLoop(const EventLoop &) = delete;
+    EventLoop &operator=(const EventLoop &) = delete;
+
+    // Calls handler whenever fd is ready for any of events (EPOLLIN, EPOLLOUT, ...); returns false on failure
+    bool watch(int fd, uint32_t events, IOHandler handler);
+    bool modify(int fd, uint32_t events);
+    void unwatch(int fd);
+
+    // Runs task once after delay; the returned ID is never 0
+    TimerID addTimer(Clock::duration delay, Task task);
+
+    // Returns false if the timer already fired or was cancelled
+    bool cancelTimer(TimerID id);
+
+    // Runs task on the loop's thread; safe to call from any thread
+    void post(Task task);
+
+    // Handles events until stop() is called
+    void run();
+
+    // Makes run() return once the current callback finishes, or right away if it hasn't started; safe to call
+    // from any thread. A stopped loop stays stopped.
+    void stop();
+};
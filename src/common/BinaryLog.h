@@ -0,0 +1,126 @@
+//
+// Created by msullivan on 12/11/24.
+//
+
+#pragma once
+#include "Format.h"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+// Binary log files, as written by Logger's binary sink and read by logdecoder.
+//
+// A file is a BinaryLogFileHeader followed by entries; an entry with size 0 (the zero fill of a file
+// that was not closed cleanly) ends it. Each entry starts with a BinaryLogEntryHeader:
+//   Module: the module's name
+//   Format: u32 format id, then the format string. The header's module and level are the call site's.
+//   Record: u64 nanoseconds since the epoch, u32 format id, then the encoded arguments
+// Every file repeats the Module and Format entries its records refer to, so it decodes on its own.
+// Integers are stored in host byte order; the header's byte order mark lets a reader reject a mismatch.
+
+constexpr char BINARY_LOG_MAGIC[8] = {'X', 'S', 'B', 'L', 'O', 'G', '\r', '\n'};
+constexpr uint16_t BINARY_LOG_VERSION = 1;
+constexpr uint16_t BINARY_LOG_BYTE_ORDER = 0x0102;
+
+struct BinaryLogFileHeader {
+    char magic[8];
+    uint16_t version;
+    uint16_t byteOrder;
+    uint32_t reserved;
+};
+static_assert(sizeof(BinaryLogFileHeader) == 16);
+
+enum class BinaryLogEntry : uint8_t {
+    End,
+    Module,
+    Format,
+    Record
+};
+
+struct BinaryLogEntryHeader {
+    uint32_t size;          // Whole entry, header included
+    BinaryLogEntry type;
+    uint8_t level;
+    uint16_t module;
+};
+static_assert(sizeof(BinaryLogEntryHeader) == 8);
+
+constexpr size_t BINARY_LOG_RECORD_PREFIX = sizeof(uint64_t) + sizeof(uint32_t);
+
+// Each argument is a tag followed by its value: 8 bytes for Int, UInt, Double and Pointer, 1 byte for
+// Bool and Char, and a u32 length plus the bytes for String
+enum class BinaryArgument : uint8_t {
+    Int = 1,
+    UInt,
+    Double,
+    Bool,
+    Char,
+    String,
+    Pointer
+};
+
+template<typename T>
+void appendBinaryValue(std::string &out, const T &value)
+{
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+// Appends one encoded argument. Accepts the same types as appendFormatArgument().
+template<typename T>
+void encodeBinaryArgument(std::string &out, const T &value)
+{
+    if constexpr (std::is_same_v<T, bool>)
+    {
+        out += static_cast<char>(BinaryArgument::Bool);
+        out += static_cast<char>(value);
+    }
+    else if constexpr (std::is_same_v<T, char>)
+    {
+        out += static_cast<char>(BinaryArgument::Char);
+        out += value;
+    }
+    else if constexpr (std::is_enum_v<T>)
+        encodeBinaryArgument(out, std::to_underlying(value));
+    else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+    {
+        out += static_cast<char>(BinaryArgument::Int);
+        appendBinaryValue(out, static_cast<int64_t>(value));
+    }
+    else if constexpr (std::is_integral_v<T>)
+    {
+        out += static_cast<char>(BinaryArgument::UInt);
+        appendBinaryValue(out, static_cast<uint64_t>(value));
+    }
+    else if constexpr (std::is_floating_point_v<T>)
+    {
+        out += static_cast<char>(BinaryArgument::Double);
+        appendBinaryValue(out, static_cast<double>(value));
+    }
+    else if constexpr (std::is_convertible_v<const T &, std::string_view>)
+    {
+        std::string_view text = value;
+        out += static_cast<char>(BinaryArgument::String);
+        appendBinaryValue(out, static_cast<uint32_t>(text.size()));
+        out.append(text);
+    }
+    else if constexpr (std::is_pointer_v<T>)
+    {
+        out += static_cast<char>(BinaryArgument::Pointer);
+        appendBinaryValue(out, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value)));
+    }
+    else
+        static_assert(alwaysFalse<T>, "No binary encoding for this argument type");
+}
+
+// Reads a value stored by appendBinaryValue()
+template<typename T>
+[[nodiscard]] T readBinaryValue(const char *in)
+{
+    T value;
+    std::memcpy(&value, in, sizeof(value));
+    return value;
+}
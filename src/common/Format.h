@@ -0,0 +1,102 @@
+//
+// Created by msullivan on 12/9/24.
+//
+
+#pragma once
+#include <charconv>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+// Minimal "{}" formatting for log messages (the toolchains we build with do not all ship <format>).
+// Every "{}" is replaced by the next argument; "{{" and "}}" produce literal braces. Placeholders
+// without an argument are left as they are, and extra arguments are ignored.
+
+template<typename T>
+inline constexpr bool alwaysFalse = false;
+
+// Appends the text form of one argument
+template<typename T>
+void appendFormatArgument(std::string &out, const T &value)
+{
+    if constexpr (std::is_same_v<T, bool>)
+        out += value ? "true" : "false";
+    else if constexpr (std::is_same_v<T, char>)
+        out += value;
+    else if constexpr (std::is_enum_v<T>)
+        appendFormatArgument(out, std::to_underlying(value));
+    else if constexpr (std::is_arithmetic_v<T>)
+    {
+        char buffer[64];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, result.ptr);
+    }
+    else if constexpr (std::is_convertible_v<const T &, std::string_view>)
+        out += std::string_view(value);
+    else if constexpr (std::is_pointer_v<T>)
+    {
+        char buffer[2 + 2 * sizeof(uintptr_t)] = {'0', 'x'};
+        auto result = std::to_chars(buffer + 2, buffer + sizeof(buffer), reinterpret_cast<uintptr_t>(value), 16);
+        out.append(buffer, result.ptr);
+    }
+    else
+        static_assert(alwaysFalse<T>, "No format conversion for this argument type");
+}
+
+// Appends fmt to out, calling appendArgument(out, index) for each of the first count placeholders
+template<typename AppendArgument>
+void formatWith(std::string &out, std::string_view fmt, size_t count, AppendArgument &&appendArgument)
+{
+    size_t next = 0;
+    while (!fmt.empty())
+    {
+        size_t brace = fmt.find_first_of("{}");
+        out.append(fmt.substr(0, brace));
+        if (brace == std::string_view::npos) break;
+
+        std::string_view token = fmt.substr(brace, 2);
+        if (token == "{}" && next < count)
+            appendArgument(out, next++);
+        else if (token == "{{" || token == "}}")
+            out += token[0];
+        else
+        {
+            // A lone brace, or a placeholder with no argument left
+            out += token[0];
+            fmt.remove_prefix(brace + 1);
+            continue;
+        }
+        fmt.remove_prefix(brace + 2);
+    }
+}
+
+// Appends fmt to out with its placeholders replaced by args
+template<typename... Args>
+void formatTo(std::string &out, std::string_view fmt, const Args &... args)
+{
+    using Appender = void (*)(std::string &, const void *);
+    const void *values[] = {static_cast<const void *>(&args)..., nullptr};
+    const Appender appenders[] = {
+        static_cast<Appender>([](std::string &target, const void *value)
+        {
+            appendFormatArgument(target, *static_cast<const Args *>(value));
+        })..., nullptr
+    };
+
+    formatWith(out, fmt, sizeof...(Args), [&](std::string &target, size_t index)
+    {
+        appenders[index](target, values[index]);
+    });
+}
+
+// Returns fmt with its placeholders replaced by args
+template<typename... Args>
+[[nodiscard]] std::string formatString(std::string_view fmt, const Args &... args)
+{
+    std::string out;
+    formatTo(out, fmt, args...);
+    return out;
+}
@@ -0,0 +1,83 @@
+//
+// Created by msullivan on 12/6/24.
+//
+
+#include "Frame.h"
+#include <algorithm>
+#include <cstring>
+
+constexpr size_t INITIAL_BUFFER_SIZE = 4096;
+constexpr size_t SHRINK_THRESHOLD = 64 * 1024;    // Idle buffers above this size are released
+
+void writeFrameHeader(char *out, uint32_t payloadSize)
+{
+    out[0] = static_cast<char>((payloadSize >> 24) & 0xFF);
+    out[1] = static_cast<char>((payloadSize >> 16) & 0xFF);
+    out[2] = static_cast<char>((payloadSize >> 8) & 0xFF);
+    out[3] = static_cast<char>(payloadSize & 0xFF);
+}
+
+uint32_t readFrameHeader(const char *in)
+{
+    auto bytes = reinterpret_cast<const unsigned char *>(in);
+    return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) |
+           (static_cast<uint32_t>(bytes[2]) << 8) | static_cast<uint32_t>(bytes[3]);
+}
+
+std::string encodeFrame(std::string_view payload)
+{
+    std::string frame(FRAME_HEADER_SIZE + payload.size(), '\0');
+    writeFrameHeader(frame.data(), static_cast<uint32_t>(payload.size()));
+    std::memcpy(frame.data() + FRAME_HEADER_SIZE, payload.data(), payload.size());
+    return frame;
+}
+
+std::span<char> FrameBuffer::prepare(size_t minSpace)
+{
+    // Nothing pending; start over at the front (and drop oversized buffers left behind by large frames)
+    if (m_Begin == m_End)
+    {
+        m_Begin = m_End = 0;
+        if (m_Buffer.size() > SHRINK_THRESHOLD)
+            std::vector<char>().swap(m_Buffer);
+    }
+
+    if (m_Buffer.size() - m_End < minSpace)
+    {
+        size_t pending = m_End - m_Begin;
+
+        // Slide the unread bytes to the front if that frees enough room; otherwise grow
+        if (m_Begin > 0 && m_Buffer.size() - pending >= minSpace)
+        {
+            std::memmove(m_Buffer.data(), m_Buffer.data() + m_Begin, pending);
+        }
+        else
+        {
+            size_t capacity = std::max({INITIAL_BUFFER_SIZE, m_Buffer.size() * 2, pending + minSpace});
+            std::vector<char> buffer(capacity);
+            std::memcpy(buffer.data(), m_Buffer.data() + m_Begin, pending);
+            m_Buffer.swap(buffer);
+        }
+        m_Begin = 0;
+        m_End = pending;
+    }
+    return {m_Buffer.data() + m_End, m_Buffer.size() - m_End};
+}
+
+void FrameBuffer::commit(size_t bytes)
+{
+    m_End += bytes;
+}
+
+FrameBuffer::Status FrameBuffer::next(std::string_view &payload, size_t maxFrameSize)
+{
+    if (size() < FRAME_HEADER_SIZE) return Status::Incomplete;
+
+    uint32_t payloadSize = readFrameHeader(m_Buffer.data() + m_Begin);
+    if (payloadSize > maxFrameSize) [[unlikely]] return Status::TooLarge;
+    if (size() < FRAME_HEADER_SIZE + payloadSize) return Status::Incomplete;
+
+    payload = {m_Buffer.data() + m_Begin + FRAME_HEADER_SIZE, payloadSize};
+    m_Begin += FRAME_HEADER_SIZE + payloadSize;
+    return Status::Frame;
+}
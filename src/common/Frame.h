@@ -0,0 +1,56 @@
+//
+// Created by msullivan on 12/6/24.
+//
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <memory>
+#include <string_view>
+#include <span>
+#include <vector>
+
+// Every message on the wire is a 4-byte big-endian payload length followed by the payload
+constexpr size_t FRAME_HEADER_SIZE = 4;
+constexpr size_t DEFAULT_MAX_FRAME_SIZE = 1 << 20;
+
+// Immutable, reference-counted payload. A payload sent to many connections is built once and
+// every send queue holds a reference to the same bytes.
+using SharedPayload = std::shared_ptr<const std::string>;
+
+// Writes the length prefix for a payload of the given size into out[0..FRAME_HEADER_SIZE)
+void writeFrameHeader(char *out, uint32_t payloadSize);
+
+// Reads the length prefix stored at in[0..FRAME_HEADER_SIZE)
+[[nodiscard]] uint32_t readFrameHeader(const char *in);
+
+// Returns the payload with its length prefix prepended
+[[nodiscard]] std::string encodeFrame(std::string_view payload);
+
+// Growable per-connection read buffer that splits a byte stream into frames
+class FrameBuffer {
+    std::vector<char> m_Buffer;
+    size_t m_Begin = 0;     // First unconsumed byte
+    size_t m_End = 0;       // One past the last received byte
+
+public:
+    enum class Status {
+        Frame,          // A complete frame was extracted
+        Incomplete,     // More bytes are needed
+        TooLarge        // The peer announced a frame above the limit; the stream can't be recovered
+    };
+
+    // Returns writable space of at least minSpace bytes at the end of the buffer (recv() straight into it)
+    [[nodiscard]] std::span<char> prepare(size_t minSpace);
+
+    // Marks bytes written into the span from prepare() as received
+    void commit(size_t bytes);
+
+    // Extracts the next complete frame. The view stays valid until the next prepare().
+    [[nodiscard]] Status next(std::string_view &payload, size_t maxFrameSize = DEFAULT_MAX_FRAME_SIZE);
+
+    [[nodiscard]] size_t size() const { return m_End - m_Begin; }
+    [[nodiscard]] bool empty() const { return m_End == m_Begin; }
+    [[nodiscard]] size_t capacity() const { return m_Buffer.size(); }
+};
@@ -0,0 +1,813 @@
+//
+// Created by msullivan on 12/17/24.
+//
+
+#include "Json.h"
+#include "JsonKernels.h"
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#include <immintrin.h>
+#define JSON_HAVE_SSE2 1
+#if defined(__GNUC__)
+#define JSON_HAVE_AVX2 1     // Compiled with a target attribute and chosen at runtime
+#endif
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define JSON_HAVE_NEON 1
+#endif
+
+/* Stage 1: classification */
+// Forward declaration(s)
+ClassifyFunction selectClassifier();
+size_t cleanPrefix(std::string_view text);
+uint64_t findEscaped(uint64_t backslash, uint64_t &previousEscaped);
+uint64_t prefixXor(uint64_t bits);
+bool isDelimiter(char c);
+void appendUTF8(std::string &out, uint32_t codepoint);
+
+// Global variables
+const ClassifyFunction g_Classify = selectClassifier();
+
+void classifyScalar(const char *block, BlockMasks &masks)
+{
+    masks = {};
+    for (unsigned i = 0; i < 64; i++)
+    {
+        uint64_t bit = uint64_t(1) << i;
+        switch (block[i])
+        {
+            case '\\': masks.backslash |= bit; break;
+            case '"': masks.quote |= bit; break;
+            case ' ': case '\t': case '\n': case '\r': masks.whitespace |= bit; break;
+            case '{': case '}': case '[': case ']': case ':': case ',': masks.operators |= bit; break;
+            default: break;
+        }
+        if (static_cast<unsigned char>(block[i]) < 0x20) masks.control |= bit;
+    }
+}
+
+#ifdef JSON_HAVE_SSE2
+void classifySSE2(const char *block, BlockMasks &masks)
+{
+    masks = {};
+    for (unsigned i = 0; i < 4; i++)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i * 16));
+        auto is = [v](char c) { return _mm_cmpeq_epi8(v, _mm_set1_epi8(c)); };
+        auto bits = [](__m128i m) { return static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(m))); };
+
+        __m128i whitespace = _mm_or_si128(_mm_or_si128(is(' '), is('\t')), _mm_or_si128(is('\n'), is('\r')));
+        __m128i operators = _mm_or_si128(_mm_or_si128(_mm_or_si128(is('{'), is('}')), _mm_or_si128(is('['), is(']'))),
+                                         _mm_or_si128(is(':'), is(',')));
+        masks.backslash |= bits(is('\\')) << (i * 16);
+        masks.quote |= bits(is('"')) << (i * 16);
+        masks.whitespace |= bits(whitespace) << (i * 16);
+        masks.operators |= bits(operators) << (i * 16);
+        __m128i control = _mm_set1_epi8(0x1F);
+        masks.control |= bits(_mm_cmpeq_epi8(_mm_max_epu8(v, control), control)) << (i * 16);
+    }
+}
+#endif
+
+#ifdef JSON_HAVE_AVX2
+__attribute__((target("avx2"))) void classifyAVX2(const char *block, BlockMasks &masks)
+{
+    masks = {};
+    for (unsigned i = 0; i < 2; i++)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + i * 32));
+        auto is = [v](char c) __attribute__((target("avx2"))) { return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c)); };
+        auto bits = [](__m256i m) __attribute__((target("avx2")))
+        {
+            return static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(m)));
+        };
+
+        __m256i whitespace = _mm256_or_si256(_mm256_or_si256(is(' '), is('\t')), _mm256_or_si256(is('\n'), is('\r')));
+        __m256i operators = _mm256_or_si256(_mm256_or_si256(_mm256_or_si256(is('{'), is('}')), _mm256_or_si256(is('['), is(']'))),
+                                            _mm256_or_si256(is(':'), is(',')));
+        masks.backslash |= bits(is('\\')) << (i * 32);
+        masks.quote |= bits(is('"')) << (i * 32);
+        masks.whitespace |= bits(whitespace) << (i * 32);
+        masks.operators |= bits(operators) << (i * 32);
+        __m256i control = _mm256_set1_epi8(0x1F);
+        masks.control |= bits(_mm256_cmpeq_epi8(_mm256_max_epu8(v, control), control)) << (i * 32);
+    }
+
+    // The caller is compiled without AVX; returning with dirty upper halves would slow its SSE code down
+    _mm256_zeroupper();
+}
+#endif
+
+#ifdef JSON_HAVE_NEON
+// Packs four byte masks (0x00 or 0xFF per byte) into 64 bits
+inline uint64_t neonBits(uint8x16_t m0, uint8x16_t m1, uint8x16_t m2, uint8x16_t m3)
+{
+    const uint8x16_t weights = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    uint8x16_t sum0 = vpaddq_u8(vandq_u8(m0, weights), vandq_u8(m1, weights));
+    uint8x16_t sum1 = vpaddq_u8(vandq_u8(m2, weights), vandq_u8(m3, weights));
+    sum0 = vpaddq_u8(sum0, sum1);
+    sum0 = vpaddq_u8(sum0, sum0);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(sum0), 0);
+}
+
+void classifyNEON(const char *block, BlockMasks &masks)
+{
+    uint8x16_t v[4];
+    for (unsigned i = 0; i < 4; i++)
+        v[i] = vld1q_u8(reinterpret_cast<const uint8_t *>(block + i * 16));
+
+    auto mask = [&v](auto &&test)
+    {
+        return neonBits(test(v[0]), test(v[1]), test(v[2]), test(v[3]));
+    };
+    auto is = [](uint8x16_t x, char c) { return vceqq_u8(x, vdupq_n_u8(static_cast<uint8_t>(c))); };
+
+    masks.backslash = mask([&](uint8x16_t x) { return is(x, '\\'); });
+    masks.quote = mask([&](uint8x16_t x) { return is(x, '"'); });
+    masks.whitespace = mask([&](uint8x16_t x)
+    {
+        return vorrq_u8(vorrq_u8(is(x, ' '), is(x, '\t')), vorrq_u8(is(x, '\n'), is(x, '\r')));
+    });
+    masks.operators = mask([&](uint8x16_t x)
+    {
+        return vorrq_u8(vorrq_u8(vorrq_u8(is(x, '{'), is(x, '}')), vorrq_u8(is(x, '['), is(x, ']'))),
+                        vorrq_u8(is(x, ':'), is(x, ',')));
+    });
+    masks.control = mask([](uint8x16_t x) { return vcleq_u8(x, vdupq_n_u8(0x1F)); });
+}
+#endif
+
+ClassifyFunction selectClassifier()
+{
+#ifdef JSON_HAVE_AVX2
+    if (__builtin_cpu_supports("avx2")) return classifyAVX2;
+#endif
+#if defined(JSON_HAVE_SSE2)
+    return classifySSE2;
+#elif defined(JSON_HAVE_NEON)
+    return classifyNEON;
+#else
+    return classifyScalar;
+#endif
+}
+
+std::span<const JsonKernel> jsonKernels()
+{
+    static const JsonKernel kernels[] = {
+        {"scalar", classifyScalar, true},
+#ifdef JSON_HAVE_SSE2
+        {"SSE2", classifySSE2, true},
+#endif
+#ifdef JSON_HAVE_AVX2
+        {"AVX2", classifyAVX2, __builtin_cpu_supports("avx2") != 0},
+#endif
+#ifdef JSON_HAVE_NEON
+        {"NEON", classifyNEON, true},
+#endif
+    };
+    return kernels;
+}
+
+// Marks the characters escaped by a backslash, carrying an odd run of backslashes into the next block
+uint64_t findEscaped(uint64_t backslash, uint64_t &previousEscaped)
+{
+    constexpr uint64_t EVEN_BITS = 0x5555555555555555ULL;
+
+    backslash &= ~previousEscaped;
+    uint64_t followsEscape = backslash << 1 | previousEscaped;
+    uint64_t oddSequenceStarts = backslash & ~EVEN_BITS & ~followsEscape;
+    uint64_t sequencesStartingOnEvenBits;
+    previousEscaped = __builtin_add_overflow(oddSequenceStarts, backslash, &sequencesStartingOnEvenBits);
+    uint64_t invertMask = sequencesStartingOnEvenBits << 1;
+    return (EVEN_BITS ^ invertMask) & followsEscape;
+}
+
+// Bit i becomes the parity of bits 0..i: set from an opening quote up to (not including) its closing quote
+uint64_t prefixXor(uint64_t bits)
+{
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+// Indexes every operator outside strings, every unescaped quote and the first byte of every other token
+bool JsonDocument::index()
+{
+    m_Structurals.clear();
+    uint64_t previousEscaped = 0, previousInString = 0, previousScalar = 0;
+    char padded[64];
+
+    for (size_t base = 0; base < m_Input.size(); base += 64)
+    {
+        const char *block = m_Input.data() + base;
+        if (m_Input.size() - base < 64)
+        {
+            std::memset(padded, ' ', sizeof(padded));
+            std::memcpy(padded, block, m_Input.size() - base);
+            block = padded;
+        }
+
+        BlockMasks masks;
+        g_Classify(block, masks);
+
+        uint64_t quote = masks.quote & ~findEscaped(masks.backslash, previousEscaped);
+        uint64_t inString = prefixXor(quote) ^ previousInString;
+        previousInString = static_cast<uint64_t>(static_cast<int64_t>(inString) >> 63);
+        if (uint64_t control = masks.control & inString) [[unlikely]]
+            return fail(base + std::countr_zero(control), "Control character in string");
+
+        uint64_t scalar = ~(masks.whitespace | masks.operators | quote | inString);
+        uint64_t scalarStart = scalar & ~(scalar << 1 | previousScalar);
+        previousScalar = scalar >> 63;
+
+        uint64_t structurals = (masks.operators & ~inString) | quote | scalarStart;
+        while (structurals)
+        {
+            m_Structurals.push_back(static_cast<uint32_t>(base + std::countr_zero(structurals)));
+            structurals &= structurals - 1;
+        }
+    }
+
+    if (previousInString) return fail(m_Input.size(), "Unterminated string");
+    return true;
+}
+
+/* Stage 2: tape */
+bool JsonDocument::parse(std::string_view input)
+{
+    m_Input = input;
+    m_Tape.clear();
+    m_Strings.clear();
+    m_Error = nullptr;
+    m_ErrorOffset = 0;
+
+    if (input.size() > UINT32_MAX) return fail(0, "Document too large");
+    if (!index()) return false;
+
+    size_t cursor = 0;
+    if (!parseValue(cursor, 0)) return false;
+    if (cursor != m_Structurals.size()) return fail(m_Structurals[cursor], "Unexpected data after the document");
+    return true;
+}
+
+bool JsonDocument::fail(size_t offset, const char *error)
+{
+    m_Tape.clear();
+    m_Error = error;
+    m_ErrorOffset = offset;
+    return false;
+}
+
+bool JsonDocument::parseValue(size_t &cursor, size_t depth)
+{
+    if (cursor >= m_Structurals.size()) return fail(m_Input.size(), "Unexpected end of document");
+    if (depth > MAX_DEPTH) return fail(m_Structurals[cursor], "Nesting too deep");
+
+    uint32_t position = m_Structurals[cursor++];
+    char c = m_Input[position];
+    size_t nodeIndex = m_Tape.size();
+    m_Tape.push_back({});
+    auto peek = [&] { return cursor < m_Structurals.size() ? m_Input[m_Structurals[cursor]] : '\0'; };
+
+    switch (c)
+    {
+        case '{':
+        case '[':
+        {
+            bool isObject = c == '{';
+            char closing = isObject ? '}' : ']';
+            uint32_t count = 0;
+            if (peek() == closing)
+                cursor++;
+            else
+                while (true)
+                {
+                    if (isObject)
+                    {
+                        if (peek() != '"')
+                            return fail(cursor < m_Structurals.size() ? m_Structurals[cursor] : m_Input.size(), "Expected a key");
+                        if (!parseValue(cursor, depth + 1)) return false;
+                        if (peek() != ':')
+                            return fail(cursor < m_Structurals.size() ? m_Structurals[cursor] : m_Input.size(), "Expected ':'");
+                        cursor++;
+                    }
+                    if (!parseValue(cursor, depth + 1)) return false;
+                    count++;
+
+                    char next = peek();
+                    cursor++;
+                    if (next == closing) break;
+                    if (next != ',')
+                        return fail(cursor - 1 < m_Structurals.size() ? m_Structurals[cursor - 1] : m_Input.size(),
+                                    isObject ? "Expected ',' or '}'" : "Expected ',' or ']'");
+                }
+
+            Node &node = m_Tape[nodeIndex];
+            node.type = isObject ? JsonType::Object : JsonType::Array;
+            node.offset = count;
+        }
+        break;
+        case '"':
+        {
+            // The closing quote is always the next structural
+            if (cursor >= m_Structurals.size()) return fail(position, "Unterminated string");
+            uint32_t end = m_Structurals[cursor++];
+            if (!parseString(position, end, m_Tape[nodeIndex])) return false;
+        }
+        break;
+        default:
+            if (!parseScalar(position, m_Tape[nodeIndex])) return false;
+        break;
+    }
+
+    m_Tape[nodeIndex].next = static_cast<uint32_t>(m_Tape.size());
+    return true;
+}
+
+bool JsonDocument::parseString(uint32_t position, uint32_t end, Node &node)
+{
+    node.type = JsonType::String;
+    std::string_view raw = m_Input.substr(position + 1, end - position - 1);
+    if (raw.find('\\') == std::string_view::npos)
+    {
+        node.offset = position + 1;
+        node.length = static_cast<uint32_t>(raw.size());
+        return true;
+    }
+
+    node.escaped = true;
+    node.offset = static_cast<uint32_t>(m_Strings.size());
+    for (size_t i = 0; i < raw.size(); i++)
+    {
+        size_t escape = raw.find('\\', i);
+        m_Strings.append(raw.substr(i, escape - i));
+        if (escape == std::string_view::npos) break;
+
+        i = escape + 1;
+        if (i == raw.size()) return fail(position + 1 + i, "Invalid escape");
+
+        switch (raw[i])
+        {
+            case '"': m_Strings += '"'; break;
+            case '\\': m_Strings += '\\'; break;
+            case '/': m_Strings += '/'; break;
+            case 'b': m_Strings += '\b'; break;
+            case 'f': m_Strings += '\f'; break;
+            case 'n': m_Strings += '\n'; break;
+            case 'r': m_Strings += '\r'; break;
+            case 't': m_Strings += '\t'; break;
+            case 'u':
+            {
+                auto readHex = [&](size_t at, uint32_t &out)
+                {
+                    if (at + 4 > raw.size()) return false;
+                    auto result = std::from_chars(raw.data() + at, raw.data() + at + 4, out, 16);
+                    return result.ec == std::errc() && result.ptr == raw.data() + at + 4;
+                };
+
+                uint32_t codepoint;
+                if (!readHex(i + 1, codepoint)) return fail(position + 1 + i, "Invalid \\u escape");
+                i += 4;
+
+                // A high surrogate must be followed by an escaped low surrogate
+                if (codepoint >= 0xD800 && codepoint <= 0xDBFF)
+                {
+                    uint32_t low;
+                    if (i + 2 >= raw.size() || raw[i + 1] != '\\' || raw[i + 2] != 'u' || !readHex(i + 3, low) ||
+                        low < 0xDC00 || low > 0xDFFF)
+                        return fail(position + 1 + i, "Invalid surrogate pair");
+                    codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                    i += 6;
+                }
+                else if (codepoint >= 0xDC00 && codepoint <= 0xDFFF)
+                    return fail(position + 1 + i, "Invalid surrogate pair");
+                appendUTF8(m_Strings, codepoint);
+            }
+            break;
+            default:
+                return fail(position + 1 + i, "Invalid escape");
+        }
+    }
+    node.length = static_cast<uint32_t>(m_Strings.size() - node.offset);
+    return true;
+}
+
+bool JsonDocument::parseScalar(uint32_t position, Node &node)
+{
+    std::string_view rest = m_Input.substr(position);
+    auto literal = [&](std::string_view word)
+    {
+        return rest.starts_with(word) && (rest.size() == word.size() || isDelimiter(rest[word.size()]));
+    };
+
+    switch (rest[0])
+    {
+        case 't':
+        case 'f':
+            if (!literal("true") && !literal("false")) return fail(position, "Unexpected character");
+            node.type = JsonType::Bool;
+            node.boolean = rest[0] == 't';
+        return true;
+        case 'n':
+            if (!literal("null")) return fail(position, "Unexpected character");
+            node.type = JsonType::Null;
+        return true;
+        case '-':
+        case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7': case '8': case '9':
+        break;
+        default:
+        return fail(position, "Unexpected character");
+    }
+
+    // Plain integers are by far the most common; take up to 19 digits without from_chars
+    bool negative = rest[0] == '-';
+    size_t length = negative ? 1 : 0;
+    uint64_t magnitude = 0;
+    size_t digits = 0;
+    while (length < rest.size() && rest[length] >= '0' && rest[length] <= '9')
+    {
+        magnitude = magnitude * 10 + static_cast<uint64_t>(rest[length++] - '0');
+        digits++;
+    }
+    if (digits == 0 || (digits > 1 && rest[negative ? 1 : 0] == '0')) return fail(position, "Invalid number");
+
+    if ((length == rest.size() || isDelimiter(rest[length])) && digits <= 19)
+    {
+        if (!negative)
+        {
+            node.type = JsonType::Integer;
+            node.unsignedInteger = magnitude > uint64_t(INT64_MAX);
+            node.integer = static_cast<int64_t>(magnitude);
+            return true;
+        }
+        if (magnitude <= uint64_t(INT64_MAX) + 1)
+        {
+            node.type = JsonType::Integer;
+            node.integer = static_cast<int64_t>(0 - magnitude);
+            return true;
+        }
+    }
+
+    // Fractions, exponents and long integers. from_chars accepts "1." and "1.e5", so the JSON grammar is
+    // checked here first: a fraction and an exponent each need at least one digit
+    auto skipDigits = [&]
+    {
+        size_t start = length;
+        while (length < rest.size() && rest[length] >= '0' && rest[length] <= '9') length++;
+        return length > start;
+    };
+    bool integral = true;
+    if (length < rest.size() && rest[length] == '.')
+    {
+        length++;
+        integral = false;
+        if (!skipDigits()) return fail(position, "Invalid number");
+    }
+    if (length < rest.size() && (rest[length] == 'e' || rest[length] == 'E'))
+    {
+        length++;
+        integral = false;
+        if (length < rest.size() && (rest[length] == '+' || rest[length] == '-')) length++;
+        if (!skipDigits()) return fail(position, "Invalid number");
+    }
+    if (length < rest.size() && !isDelimiter(rest[length])) return fail(position, "Invalid number");
+    const char *end = rest.data() + length;
+
+    if (integral && !negative)
+    {
+        uint64_t value;
+        auto result = std::from_chars(rest.data(), end, value);
+        if (result.ec == std::errc() && result.ptr == end)
+        {
+            node.type = JsonType::Integer;
+            node.unsignedInteger = value > uint64_t(INT64_MAX);
+            node.integer = static_cast<int64_t>(value);
+            return true;
+        }
+    }
+
+    auto result = std::from_chars(rest.data(), end, node.number);
+    if (result.ptr != end || (result.ec != std::errc() && result.ec != std::errc::result_out_of_range))
+        return fail(position, "Invalid number");
+
+    // from_chars leaves the value alone when it is out of range: underflow is a valid number that rounds to
+    // zero, but a number beyond the largest double has no value to store
+    if (result.ec == std::errc::result_out_of_range)
+    {
+        std::string text(rest.data(), length);
+        node.number = std::strtod(text.c_str(), nullptr);
+        if (std::isinf(node.number)) return fail(position, "Number out of range");
+    }
+    node.type = JsonType::Double;
+    return true;
+}
+
+bool isDelimiter(char c)
+{
+    switch (c)
+    {
+        case ' ': case '\t': case '\n': case '\r':
+        case '{': case '}': case '[': case ']': case ':': case ',': case '"':
+            return true;
+        default:
+            return false;
+    }
+}
+
+void appendUTF8(std::string &out, uint32_t codepoint)
+{
+    if (codepoint < 0x80)
+        out += static_cast<char>(codepoint);
+    else if (codepoint < 0x800)
+    {
+        out += static_cast<char>(0xC0 | (codepoint >> 6));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    }
+    else if (codepoint < 0x10000)
+    {
+        out += static_cast<char>(0xE0 | (codepoint >> 12));
+        out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    }
+    else
+    {
+        out += static_cast<char>(0xF0 | (codepoint >> 18));
+        out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    }
+}
+
+/* Values */
+JsonType JsonValue::type() const
+{
+    return m_Document->m_Tape[m_Index].type;
+}
+
+bool JsonValue::get(bool &out) const
+{
+    if (!*this || type() != JsonType::Bool) return false;
+    out = m_Document->m_Tape[m_Index].boolean;
+    return true;
+}
+
+bool JsonValue::get(int64_t &out) const
+{
+    if (!*this || type() != JsonType::Integer || m_Document->m_Tape[m_Index].unsignedInteger) return false;
+    out = m_Document->m_Tape[m_Index].integer;
+    return true;
+}
+
+bool JsonValue::get(uint64_t &out) const
+{
+    if (!*this) return false;
+    const auto &node = m_Document->m_Tape[m_Index];
+    if (node.type != JsonType::Integer || (node.integer < 0 && !node.unsignedInteger)) return false;
+    out = static_cast<uint64_t>(node.integer);
+    return true;
+}
+
+bool JsonValue::get(double &out) const
+{
+    if (!*this) return false;
+    const auto &node = m_Document->m_Tape[m_Index];
+    if (node.type == JsonType::Double)
+        out = node.number;
+    else if (node.type == JsonType::Integer)
+        out = node.unsignedInteger ? static_cast<double>(static_cast<uint64_t>(node.integer)) : static_cast<double>(node.integer);
+    else
+        return false;
+    return true;
+}
+
+bool JsonValue::get(std::string_view &out) const
+{
+    if (!*this || type() != JsonType::String) return false;
+    const auto &node = m_Document->m_Tape[m_Index];
+    out = node.escaped ? std::string_view(m_Document->m_Strings).substr(node.offset, node.length)
+                       : m_Document->m_Input.substr(node.offset, node.length);
+    return true;
+}
+
+JsonValue JsonValue::operator[](std::string_view key) const
+{
+    if (!*this || type() != JsonType::Object) return {};
+    const auto &tape = m_Document->m_Tape;
+    for (uint32_t child = m_Index + 1; child < tape[m_Index].next; child = tape[child + 1].next)
+    {
+        std::string_view name;
+        if (JsonValue(m_Document, child).get(name) && name == key)
+            return {m_Document, child + 1};
+    }
+    return {};
+}
+
+JsonValue JsonValue::at(size_t index) const
+{
+    if (!*this || type() != JsonType::Array || index >= size()) return {};
+    const auto &tape = m_Document->m_Tape;
+    uint32_t child = m_Index + 1;
+    for (size_t i = 0; i < index; i++)
+        child = tape[child].next;
+    return {m_Document, child};
+}
+
+size_t JsonValue::size() const
+{
+    if (!*this || (type() != JsonType::Array && type() != JsonType::Object)) return 0;
+    return m_Document->m_Tape[m_Index].offset;
+}
+
+/* Writer */
+void JsonWriter::clear()
+{
+    m_Size = 0;
+    m_Depth = 0;
+    m_HasElements = 0;
+    m_AfterKey = false;
+    m_Overflowed = false;
+}
+
+void JsonWriter::put(char c)
+{
+    if (m_Size == m_Buffer.size())
+    {
+        m_Overflowed = true;
+        return;
+    }
+    m_Buffer[m_Size++] = c;
+}
+
+void JsonWriter::put(std::string_view text)
+{
+    if (m_Buffer.size() - m_Size < text.size())
+    {
+        m_Overflowed = true;
+        return;
+    }
+    std::memcpy(m_Buffer.data() + m_Size, text.data(), text.size());
+    m_Size += text.size();
+}
+
+// Writes text as a quoted string, copying runs that need no escaping in one go
+void JsonWriter::putEscaped(std::string_view text)
+{
+    static constexpr char HEX[] = "0123456789abcdef";
+
+    put('"');
+    while (true)
+    {
+        size_t clean = cleanPrefix(text);
+        put(text.substr(0, clean));
+        if (clean == text.size()) break;
+
+        char c = text[clean];
+        switch (c)
+        {
+            case '"': put("\\\""); break;
+            case '\\': put("\\\\"); break;
+            case '\n': put("\\n"); break;
+            case '\r': put("\\r"); break;
+            case '\t': put("\\t"); break;
+            case '\b': put("\\b"); break;
+            case '\f': put("\\f"); break;
+            default:
+            {
+                char escape[] = {'\\', 'u', '0', '0', HEX[(c >> 4) & 0xF], HEX[c & 0xF]};
+                put(std::string_view(escape, sizeof(escape)));
+            }
+            break;
+        }
+        text.remove_prefix(clean + 1);
+    }
+    put('"');
+}
+
+void JsonWriter::separate()
+{
+    if (m_AfterKey)
+    {
+        m_AfterKey = false;
+        return;
+    }
+    uint64_t bit = uint64_t(1) << m_Depth;
+    if (m_HasElements & bit) put(',');
+    m_HasElements |= bit;
+}
+
+void JsonWriter::open(char bracket)
+{
+    separate();
+    put(bracket);
+    if (++m_Depth >= MAX_DEPTH)
+    {
+        m_Overflowed = true;
+        m_Depth = MAX_DEPTH - 1;
+    }
+    m_HasElements &= ~(uint64_t(1) << m_Depth);
+}
+
+void JsonWriter::close(char bracket)
+{
+    if (m_Depth > 0) m_Depth--;
+    put(bracket);
+}
+
+JsonWriter &JsonWriter::key(std::string_view name)
+{
+    separate();
+    putEscaped(name);
+    put(':');
+    m_AfterKey = true;
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(std::string_view text)
+{
+    separate();
+    putEscaped(text);
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(int64_t number)
+{
+    separate();
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    put(std::string_view(digits, result.ptr - digits));
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(uint64_t number)
+{
+    separate();
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    put(std::string_view(digits, result.ptr - digits));
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(double number)
+{
+    // JSON has no NaN or infinity
+    if (!std::isfinite(number)) return null();
+
+    separate();
+    char digits[32];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    put(std::string_view(digits, result.ptr - digits));
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(bool boolean)
+{
+    separate();
+    put(boolean ? "true" : "false");
+    return *this;
+}
+
+JsonWriter &JsonWriter::null()
+{
+    separate();
+    put("null");
+    return *this;
+}
+
+// Number of leading bytes that can be written inside a JSON string as they are
+size_t cleanPrefix(std::string_view text)
+{
+    size_t i = 0;
+#if defined(JSON_HAVE_SSE2)
+    const __m128i quote = _mm_set1_epi8('"'), backslash = _mm_set1_epi8('\\'), control = _mm_set1_epi8(0x1F);
+    for (; i + 16 <= text.size(); i += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text.data() + i));
+        __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+                                       _mm_cmpeq_epi8(_mm_max_epu8(v, control), control));
+        if (int mask = _mm_movemask_epi8(special)) return i + std::countr_zero(static_cast<unsigned>(mask));
+    }
+#elif defined(JSON_HAVE_NEON)
+    for (; i + 16 <= text.size(); i += 16)
+    {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(text.data() + i));
+        uint8x16_t special = vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8('"')), vceqq_u8(v, vdupq_n_u8('\\'))),
+                                      vcleq_u8(v, vdupq_n_u8(0x1F)));
+        if (vmaxvq_u8(special)) break;     // The scalar loop below finds the exact byte
+    }
+#endif
+    for (; i < text.size(); i++)
+    {
+        auto c = static_cast<unsigned char>(text[i]);
+        if (c == '"' || c == '\\' || c < 0x20) return i;
+    }
+    return text.size();
+}
@@ -0,0 +1,168 @@
+//
+// Created by msullivan on 12/17/24.
+//
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// JSON for bot clients and command arguments.
+//
+// JsonDocument parses in two passes, after simdjson: the first classifies 64 bytes at a time with SIMD (AVX2
+// when the CPU has it, otherwise SSE2 or NEON, with a scalar fallback) into an index of the structural
+// characters outside strings; the second walks that index into a flat tape. Strings without escapes are views
+// into the input, which must therefore outlive the document. UTF-8 in strings is passed through unchecked.
+//
+// JsonWriter writes into a caller-provided buffer and never allocates.
+
+enum class JsonType : uint8_t { Null, Bool, Integer, Double, String, Array, Object };
+
+class JsonDocument;
+
+// A value inside a JsonDocument; cheap to copy, valid while the document is
+class JsonValue {
+    const JsonDocument *m_Document = nullptr;
+    uint32_t m_Index = 0;
+
+public:
+    JsonValue() = default;
+    JsonValue(const JsonDocument *document, uint32_t index) : m_Document(document), m_Index(index) {}
+
+    // False for the value returned by a failed lookup
+    explicit operator bool() const { return m_Document != nullptr; }
+
+    [[nodiscard]] JsonType type() const;
+    [[nodiscard]] bool isNull() const { return *this && type() == JsonType::Null; }
+    [[nodiscard]] bool isNumber() const { return *this && (type() == JsonType::Integer || type() == JsonType::Double); }
+
+    // Conversions return false (and leave out alone) if the value has another type
+    bool get(bool &out) const;
+    bool get(int64_t &out) const;
+    bool get(uint64_t &out) const;
+    bool get(double &out) const;
+    bool get(std::string_view &out) const;
+
+    // Object member by key; an empty value if this is not an object or has no such key
+    [[nodiscard]] JsonValue operator[](std::string_view key) const;
+
+    // Array element by position; an empty value if out of range
+    [[nodiscard]] JsonValue at(size_t index) const;
+
+    // Number of elements or members of an array or object
+    [[nodiscard]] size_t size() const;
+
+    // Calls visit(value) for each array element, or visit(key, value) for each object member
+    template<typename Visitor>
+    void forEach(Visitor &&visit) const;
+};
+
+class JsonDocument {
+    friend class JsonValue;
+
+    struct Node {
+        JsonType type;
+        bool escaped = false;       // String: the text lives in m_Strings
+        bool unsignedInteger = false;   // Integer: above INT64_MAX, kept as uint64_t bits
+        uint32_t next = 0;          // Tape index just past this value (and its children)
+        uint32_t offset = 0;        // String: start of the text; Array/Object: element or member count
+        uint32_t length = 0;        // String: length of the text
+        union {
+            bool boolean;
+            int64_t integer;
+            double number;
+        };
+    };
+
+    std::string_view m_Input;
+    std::vector<uint32_t> m_Structurals;    // Offsets of structural characters and of scalars
+    std::vector<Node> m_Tape;
+    std::string m_Strings;                  // Unescaped text of strings that had escapes
+    size_t m_ErrorOffset = 0;
+    const char *m_Error = nullptr;
+
+    bool index();
+    bool parseValue(size_t &cursor, size_t depth);
+    bool parseString(uint32_t position, uint32_t end, Node &node);
+    bool parseScalar(uint32_t position, Node &node);
+    bool fail(size_t offset, const char *error);
+
+public:
+    static constexpr size_t MAX_DEPTH = 256;
+
+    // Parses input, replacing any earlier document; buffers are reused. Returns false on malformed input.
+    bool parse(std::string_view input);
+
+    [[nodiscard]] JsonValue root() const { return m_Tape.empty() ? JsonValue() : JsonValue(this, 0); }
+    [[nodiscard]] const char *error() const { return m_Error; }
+    [[nodiscard]] size_t errorOffset() const { return m_ErrorOffset; }
+};
+
+class JsonWriter {
+    static constexpr size_t MAX_DEPTH = 64;
+
+    std::span<char> m_Buffer;
+    size_t m_Size = 0;
+    size_t m_Depth = 0;
+    uint64_t m_HasElements = 0;     // Bit per depth: a separator is due before the next value
+    bool m_AfterKey = false;
+    bool m_Overflowed = false;
+
+    void separate();
+    void put(char c);
+    void put(std::string_view text);
+    void putEscaped(std::string_view text);
+    void open(char bracket);
+    void close(char bracket);
+
+public:
+    explicit JsonWriter(std::span<char> buffer) : m_Buffer(buffer) {}
+
+    JsonWriter &beginObject() { open('{'); return *this; }
+    JsonWriter &endObject() { close('}'); return *this; }
+    JsonWriter &beginArray() { open('['); return *this; }
+    JsonWriter &endArray() { close(']'); return *this; }
+    JsonWriter &key(std::string_view name);
+    JsonWriter &value(std::string_view text);
+    JsonWriter &value(const char *text) { return value(std::string_view(text)); }
+    JsonWriter &value(int64_t number);
+    JsonWriter &value(uint64_t number);
+    JsonWriter &value(int number) { return value(static_cast<int64_t>(number)); }
+    JsonWriter &value(double number);
+    JsonWriter &value(bool boolean);
+    JsonWriter &null();
+
+    // False if the buffer was too small; the output is then truncated and must not be used
+    [[nodiscard]] bool ok() const { return !m_Overflowed; }
+    [[nodiscard]] std::string_view view() const { return {m_Buffer.data(), m_Size}; }
+    [[nodiscard]] size_t size() const { return m_Size; }
+    void clear();
+};
+
+template<typename Visitor>
+void JsonValue::forEach(Visitor &&visit) const
+{
+    if (!*this) return;
+    const auto &tape = m_Document->m_Tape;
+    JsonType containerType = tape[m_Index].type;
+    if (containerType != JsonType::Array && containerType != JsonType::Object) return;
+
+    for (uint32_t child = m_Index + 1; child < tape[m_Index].next;)
+    {
+        if (containerType == JsonType::Array)
+        {
+            visit(JsonValue(m_Document, child));
+            child = tape[child].next;
+        }
+        else
+        {
+            std::string_view name;
+            JsonValue(m_Document, child).get(name);
+            visit(name, JsonValue(m_Document, child + 1));
+            child = tape[child + 1].next;
+        }
+    }
+}
@@ -0,0 +1,32 @@
+//
+// Created by msullivan on 12/17/24.
+//
+
+#pragma once
+#include <cstdint>
+#include <span>
+
+// Stage 1 of JsonDocument (see Json.h): the kernels that classify 64-byte blocks. JsonDocument uses the best
+// one the CPU supports; they are listed here so they can be cross-checked against the scalar one.
+
+// Bit i of each mask describes byte i of a 64-byte block
+struct BlockMasks {
+    uint64_t backslash = 0;
+    uint64_t quote = 0;
+    uint64_t whitespace = 0;
+    uint64_t operators = 0;     // { } [ ] : ,
+    uint64_t control = 0;       // Below 0x20, which strings may only contain escaped
+
+    bool operator==(const BlockMasks &) const = default;
+};
+
+using ClassifyFunction = void (*)(const char *block, BlockMasks &masks);
+
+struct JsonKernel {
+    const char *name;
+    ClassifyFunction classify;
+    bool supported;     // The CPU can run it
+};
+
+// Every kernel in this build, scalar first
+std::span<const JsonKernel> jsonKernels();
@@ -3,31 +3,132 @@
 //
 
 #include "Message.h"
-#include <iomanip>
+#include "Format.h"
+#include "Json.h"
+#include "Timestamp.h"
+#include <bit>
+#include <cstring>
 #include <utility>
 
-// Will eventually need to have JSON formatting
+// Forward declaration(s)
+template<typename T> void storeBigEndian(char *out, T value);
+template<typename T> T loadBigEndian(const char *in);
+int64_t toNanoseconds(std::chrono::system_clock::time_point time);
 
-[[maybe_unused]] Message::Message(std::string ip, unsigned int port, std::string content)
-        : m_SenderIP(std::move(ip)), m_SenderPort(port), m_Content(std::move(content)), m_Timestamp(std::chrono::system_clock::now())
+std::chrono::system_clock::time_point MessageView::time() const
+{
+    return std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(timestamp)));
+}
+
+size_t encodeMessage(std::span<char> out, uint64_t senderID, int64_t timestamp, std::string_view content)
+{
+    char *header = out.data();
+    header[0] = static_cast<char>(MESSAGE_WIRE_VERSION);
+    header[1] = 0;
+    storeBigEndian(header + 2, static_cast<uint16_t>(MESSAGE_HEADER_SIZE));
+    storeBigEndian(header + 4, static_cast<uint32_t>(content.size()));
+    storeBigEndian(header + 8, senderID);
+    storeBigEndian(header + 16, static_cast<uint64_t>(timestamp));
+    std::memcpy(header + MESSAGE_HEADER_SIZE, content.data(), content.size());
+    return encodedMessageSize(content.size());
+}
+
+bool decodeMessage(std::string_view data, MessageView &message)
+{
+    if (data.size() < MESSAGE_HEADER_SIZE) return false;
+    if (static_cast<uint8_t>(data[0]) != MESSAGE_WIRE_VERSION) return false;
+
+    auto headerSize = loadBigEndian<uint16_t>(data.data() + 2);
+    auto contentSize = loadBigEndian<uint32_t>(data.data() + 4);
+    if (headerSize < MESSAGE_HEADER_SIZE || headerSize > data.size() || data.size() - headerSize != contentSize)
+        return false;
+
+    message.senderID = loadBigEndian<uint64_t>(data.data() + 8);
+    message.timestamp = static_cast<int64_t>(loadBigEndian<uint64_t>(data.data() + 16));
+    message.content = data.substr(headerSize);
+    return true;
+}
+
+bool writeMessageJson(JsonWriter &writer, const MessageView &message)
+{
+    writer.beginObject()
+          .key("v").value(static_cast<int64_t>(MESSAGE_WIRE_VERSION))
+          .key("sender").value(message.senderID)
+          .key("timestamp").value(message.timestamp)
+          .key("content").value(message.content)
+          .endObject();
+    return writer.ok();
+}
+
+bool readMessageJson(JsonValue value, MessageView &message)
+{
+    int64_t version;
+    if (!value["v"].get(version) || version != MESSAGE_WIRE_VERSION) return false;
+    return value["sender"].get(message.senderID) && value["timestamp"].get(message.timestamp) &&
+           value["content"].get(message.content);
+}
+
+Message::Message(uint64_t senderID, std::string_view content, std::chrono::system_clock::time_point timestamp,
+                 const allocator_type &allocator)
+        : m_SenderID(senderID), m_Content(content, allocator), m_Timestamp(timestamp)
 {}
 
-std::string Message::timestamp() const
+Message::Message(const MessageView &view, const allocator_type &allocator)
+        : m_SenderID(view.senderID), m_Content(view.content, allocator), m_Timestamp(view.time())
+{}
+
+Message::Message(const Message &other, const allocator_type &allocator)
+        : m_SenderID(other.m_SenderID), m_Content(other.m_Content, allocator), m_Timestamp(other.m_Timestamp)
+{}
+
+Message::Message(Message &&other, const allocator_type &allocator)
+        : m_SenderID(other.m_SenderID), m_Content(std::move(other.m_Content), allocator), m_Timestamp(other.m_Timestamp)
+{}
+
+MessageView Message::view() const
 {
-    auto time = std::chrono::system_clock::to_time_t(m_Timestamp);  // Convert to time_t
-    std::tm* tm = std::localtime(&time);                             // Convert to local time
+    return {m_SenderID, toNanoseconds(m_Timestamp), m_Content};
+}
 
-    std::stringstream ss;
-    ss << std::put_time(tm, "%a %b %d %H:%M:%S %Y");  // Format timestamp as a string
-    return ss.str();
+std::string Message::timestamp() const
+{
+    thread_local TimestampCache cache("%a %b %d %H:%M:%S %Y");
+    return cache.format(m_Timestamp);
 }
 
 std::string Message::toString() const
 {
-    std::stringstream ss;
-    ss << "[SenderIP: " << m_SenderIP << "] ";
-    ss << "[SenderPort: " << m_SenderPort << "] ";
-    ss << "[Timestamp: " << timestamp() << "] ";
-    ss << "[Content: " << m_Content << "]";
-    return ss.str();
-}
\ No newline at end of file
+    return formatString("[Sender: {}] [Timestamp: {}] [Content: {}]", m_SenderID, timestamp(), m_Content);
+}
+
+void Message::encode(std::string &out) const
+{
+    size_t offset = out.size();
+    out.resize_and_overwrite(offset + encodedMessageSize(m_Content.size()), [&](char *data, size_t length)
+    {
+        encodeMessage({data + offset, length - offset}, m_SenderID, toNanoseconds(m_Timestamp), m_Content);
+        return length;
+    });
+}
+
+template<typename T>
+void storeBigEndian(char *out, T value)
+{
+    if constexpr (std::endian::native == std::endian::little) value = std::byteswap(value);
+    std::memcpy(out, &value, sizeof(T));
+}
+
+template<typename T>
+T loadBigEndian(const char *in)
+{
+    T value;
+    std::memcpy(&value, in, sizeof(T));
+    if constexpr (std::endian::native == std::endian::little) value = std::byteswap(value);
+    return value;
+}
+
+int64_t toNanoseconds(std::chrono::system_clock::time_point time)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
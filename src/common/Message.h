@@ -3,23 +3,90 @@
 //
 
 #pragma once
-#include <string>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <string_view>
 
-class Message {
-public:
-    [[maybe_unused]] Message(std::string ip, unsigned int port, std::string body);
+// Wire encoding of a chat message, version 1. Broadcasts go out as frames whose payload is one encoded message;
+// direct replies from the server stay plain text. All integers are big-endian, like the frame header.
+//
+//   offset  size  field
+//        0     1  version         MESSAGE_WIRE_VERSION
+//        1     1  flags           Reserved; written as 0
+//        2     2  header size     Bytes before the content; later versions may append fields
+//        4     4  content length
+//        8     8  sender id
+//       16     8  timestamp       Nanoseconds since the Unix epoch
+//       24     -  content
+//
+// Decoders accept any header at least MESSAGE_HEADER_SIZE bytes long and skip the fields they don't know.
+constexpr uint8_t MESSAGE_WIRE_VERSION = 1;
+constexpr size_t MESSAGE_HEADER_SIZE = 24;
+
+// Forward declaration(s)
+class JsonValue;
+class JsonWriter;
+
+// A decoded message that references the buffer it was decoded from; valid as long as that buffer is
+struct MessageView {
+    uint64_t senderID = 0;
+    int64_t timestamp = 0;          // Nanoseconds since the Unix epoch
+    std::string_view content;
+
+    [[nodiscard]] std::chrono::system_clock::time_point time() const;
+};
+
+// Bytes needed to encode a message with content of the given size
+[[nodiscard]] constexpr size_t encodedMessageSize(size_t contentSize) { return MESSAGE_HEADER_SIZE + contentSize; }
 
-private:
-    const std::string m_SenderIP;
-    const unsigned int m_SenderPort;
-    std::string m_Content;
+// Encodes a message into out, which must hold encodedMessageSize(content.size()) bytes; returns the bytes written
+size_t encodeMessage(std::span<char> out, uint64_t senderID, int64_t timestamp, std::string_view content);
+
+// Decodes a message without copying it; returns false if data is not a complete message of a known version
+[[nodiscard]] bool decodeMessage(std::string_view data, MessageView &message);
+
+// JSON form for clients that speak JSON: {"v":1,"sender":<id>,"timestamp":<ns>,"content":"..."}
+bool writeMessageJson(JsonWriter &writer, const MessageView &message);
+
+// Reads the JSON form; the content references the parsed document. Returns false if fields are missing.
+[[nodiscard]] bool readMessageJson(JsonValue value, MessageView &message);
+
+// An owned message. It is allocator-aware: constructed with NetworkEngine::frameArena() (or any other
+// memory resource), its content lives in that resource, and containers using a polymorphic_allocator pass theirs
+// down. Getters return references and views; nothing is copied out.
+class Message {
+    uint64_t m_SenderID;
+    std::pmr::string m_Content;
     std::chrono::system_clock::time_point m_Timestamp;
 
 public:
-    [[nodiscard]] std::string ip() const { return m_SenderIP; }
-    [[nodiscard]] unsigned int port() const { return m_SenderPort; }
-    [[nodiscard]] std::string content() const { return m_Content; }
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    Message(uint64_t senderID, std::string_view content,
+            std::chrono::system_clock::time_point timestamp = std::chrono::system_clock::now(),
+            const allocator_type &allocator = {});
+    explicit Message(const MessageView &view, const allocator_type &allocator = {});
+    Message(const Message &other, const allocator_type &allocator);
+    Message(Message &&other, const allocator_type &allocator);
+    Message(const Message &) = default;
+    Message(Message &&) noexcept = default;
+    Message &operator=(const Message &) = default;
+    Message &operator=(Message &&) = default;
+
+    [[nodiscard]] uint64_t senderID() const { return m_SenderID; }
+    [[nodiscard]] std::string_view content() const { return m_Content; }
+    [[nodiscard]] const std::chrono::system_clock::time_point &time() const { return m_Timestamp; }
     [[nodiscard]] std::string timestamp() const;
     [[nodiscard]] std::string toString() const;
-};
\ No newline at end of file
+    [[nodiscard]] allocator_type get_allocator() const { return m_Content.get_allocator(); }
+
+    // A view of this message, valid while the message is
+    [[nodiscard]] MessageView view() const;
+
+    // Appends the wire encoding to out
+    void encode(std::string &out) const;
+};
@@ -0,0 +1,48 @@
+//
+// Created by msullivan on 12/10/24.
+//
+
+#include "Timestamp.h"
+
+TimestampCache::TimestampCache(const char *pattern) : m_Pattern(pattern)
+{}
+
+void TimestampCache::append(std::string &out, std::chrono::system_clock::time_point time, TimestampPrecision precision)
+{
+    auto seconds = std::chrono::floor<std::chrono::seconds>(time);
+    std::time_t second = std::chrono::system_clock::to_time_t(seconds);
+    if (second != m_Second)
+    {
+        std::tm tm {};
+        localtime_r(&second, &tm);
+        m_Length = std::strftime(m_Text, sizeof(m_Text), m_Pattern, &tm);
+        m_Second = second;
+    }
+    out.append(m_Text, m_Length);
+
+    if (precision == TimestampPrecision::Seconds) return;
+
+    // ".mmm" or ".uuuuuu", zero-padded
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(time - seconds).count();
+    int digits = 6;
+    if (precision == TimestampPrecision::Milliseconds)
+    {
+        micros /= 1000;
+        digits = 3;
+    }
+
+    char suffix[8] = {'.'};
+    for (int i = digits; i > 0; i--)
+    {
+        suffix[i] = static_cast<char>('0' + micros % 10);
+        micros /= 10;
+    }
+    out.append(suffix, digits + 1);
+}
+
+std::string TimestampCache::format(std::chrono::system_clock::time_point time, TimestampPrecision precision)
+{
+    std::string out;
+    append(out, time, precision);
+    return out;
+}
@@ -0,0 +1,39 @@
+//
+// Created by msullivan on 12/10/24.
+//
+
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <ctime>
+#include <string>
+
+// Digits shown after the seconds
+enum class TimestampPrecision {
+    Seconds,
+    Milliseconds,   // ".123"
+    Microseconds    // ".123456"
+};
+
+// Formats local timestamps with a strftime pattern, calling localtime_r and strftime only when the
+// second changes; the sub-second suffix is appended from the cached text with a few digit writes.
+// An instance is not thread-safe: give each thread (or each lock-protected writer) its own.
+class TimestampCache {
+    static constexpr size_t MAX_TEXT_SIZE = 64;
+
+    const char *m_Pattern;
+    std::time_t m_Second = -1;
+    char m_Text[MAX_TEXT_SIZE] {};
+    size_t m_Length = 0;
+
+public:
+    explicit TimestampCache(const char *pattern = "%Y-%m-%d %H:%M:%S");
+
+    // Appends the formatted time to out
+    void append(std::string &out, std::chrono::system_clock::time_point time,
+                TimestampPrecision precision = TimestampPrecision::Seconds);
+
+    // Returns the formatted time
+    [[nodiscard]] std::string format(std::chrono::system_clock::time_point time,
+                                     TimestampPrecision precision = TimestampPrecision::Seconds);
+};
@@ -0,0 +1,136 @@
+//
+// Created by msullivan on 11/11/24.
+//
+
+#include "UUID.h"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <random>
+#ifdef __linux__
+#include <sys/random.h>
+#endif
+
+namespace {
+    // xoshiro256** (Blackman and Vigna): small, fast, and good enough for identifiers that must not collide but
+    // need not be secret
+    class Random {
+        uint64_t m_State[4];
+
+        static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    public:
+        Random()
+        {
+            bool seeded = false;
+#ifdef __linux__
+            seeded = getrandom(m_State, sizeof(m_State), 0) == sizeof(m_State);
+#endif
+            if (!seeded)
+            {
+                std::random_device device;
+                for (uint64_t &word : m_State)
+                    word = static_cast<uint64_t>(device()) << 32 | device();
+            }
+
+            // The all-zero state is the one state the generator cannot leave
+            if ((m_State[0] | m_State[1] | m_State[2] | m_State[3]) == 0) m_State[0] = 0x9e3779b97f4a7c15;
+        }
+
+        uint64_t next()
+        {
+            uint64_t result = rotl(m_State[1] * 5, 7) * 9;
+            uint64_t t = m_State[1] << 17;
+            m_State[2] ^= m_State[0];
+            m_State[3] ^= m_State[1];
+            m_State[1] ^= m_State[2];
+            m_State[0] ^= m_State[3];
+            m_State[2] ^= t;
+            m_State[3] = rotl(m_State[3], 45);
+            return result;
+        }
+    };
+
+    thread_local Random t_Random;
+
+    void storeBigEndian(uint8_t *out, uint64_t value)
+    {
+        if constexpr (std::endian::native == std::endian::little) value = std::byteswap(value);
+        std::memcpy(out, &value, sizeof(value));
+    }
+
+    // "000102...feff": the two hex digits of every byte value
+    constexpr auto HEX_PAIRS = []
+    {
+        constexpr char digits[] = "0123456789abcdef";
+        std::array<char, 512> pairs {};
+        for (size_t i = 0; i < 256; i++)
+        {
+            pairs[2 * i] = digits[i >> 4];
+            pairs[2 * i + 1] = digits[i & 0xf];
+        }
+        return pairs;
+    }();
+
+    // Where each byte's digits go in the canonical form
+    constexpr size_t HEX_OFFSETS[16] = {0, 2, 4, 6, 9, 11, 14, 16, 19, 21, 24, 26, 28, 30, 32, 34};
+}
+
+UUID::UUID() : UUID(v4())
+{}
+
+UUID UUID::nil()
+{
+    return UUID(NoInit {});
+}
+
+UUID UUID::v4()
+{
+    UUID uuid {NoInit {}};
+    storeBigEndian(uuid.m_Bytes.data(), t_Random.next());
+    storeBigEndian(uuid.m_Bytes.data() + 8, t_Random.next());
+    uuid.m_Bytes[6] = (uuid.m_Bytes[6] & 0x0f) | 0x40;     // Version 4
+    uuid.m_Bytes[8] = (uuid.m_Bytes[8] & 0x3f) | 0x80;     // Variant 10
+    return uuid;
+}
+
+UUID UUID::v7()
+{
+    // 48 bits of milliseconds followed by 12 bits of the fraction of the millisecond (RFC 9562, method 3). If the
+    // clock hasn't moved on, or has gone back, the last value is incremented, so a thread's UUIDs strictly increase.
+    thread_local uint64_t t_Last = 0;
+    auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    uint64_t milliseconds = static_cast<uint64_t>(nanoseconds) / 1'000'000;
+    uint64_t fraction = static_cast<uint64_t>(nanoseconds) % 1'000'000 * 4096 / 1'000'000;
+    uint64_t time = std::max(milliseconds << 12 | fraction, t_Last + 1);
+    t_Last = time;
+
+    UUID uuid {NoInit {}};
+    storeBigEndian(uuid.m_Bytes.data(), (time >> 12) << 16 | 0x7000 | (time & 0xfff));     // Version 7
+    storeBigEndian(uuid.m_Bytes.data() + 8, t_Random.next());
+    uuid.m_Bytes[8] = (uuid.m_Bytes[8] & 0x3f) | 0x80;     // Variant 10
+    return uuid;
+}
+
+void UUID::format(char *out) const
+{
+    for (size_t i = 0; i < 16; i++)
+        std::memcpy(out + HEX_OFFSETS[i], &HEX_PAIRS[2 * m_Bytes[i]], 2);
+    out[8] = out[13] = out[18] = out[23] = '-';
+}
+
+std::array<char, UUID::STRING_SIZE> UUID::toChars() const
+{
+    std::array<char, STRING_SIZE> text;
+    format(text.data());
+    return text;
+}
+
+std::string UUID::toString() const
+{
+    std::string text(STRING_SIZE, '\0');
+    format(text.data());
+    return text;
+}
@@ -2,42 +2,59 @@
 // Created by msullivan on 11/11/24.
 //
 
-#include <random>
-#include <sstream>
-#include <iomanip>
+#pragma once
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
 
+// RFC 9562 UUIDs for tagging messages and sessions.
+//
+// Random bits come from a per-thread xoshiro256** generator seeded once from the kernel, so generating takes no
+// lock and makes no system call. Version 7 puts the Unix time in milliseconds first, which keeps keys that are
+// generated together close together in an index; within a thread, each v7 UUID is greater than the one before.
 class UUID {
+    std::array<uint8_t, 16> m_Bytes {};
+
 public:
-    UUID()
-    {
-        generate();
-    }
+    static constexpr size_t STRING_SIZE = 36;
 
-    std::string toString() const
-    {
-        std::ostringstream oss;
-        oss << std::hex << std::setfill('0');
-        for (size_t i = 0; i < 16; ++i) {
-            oss << std::setw(2) << static_cast<int>(data[i]);
-            if (i == 3 || i == 5 || i == 7 || i == 9) {
-                oss << '-';
-            }
-        }
-        return oss.str();
-    }
+    // A random (version 4) UUID
+    UUID();
+
+    // The nil UUID, all zeroes
+    static UUID nil();
+    static UUID v4();
+    static UUID v7();
+
+    // Writes the canonical "xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx" form into out, which needs STRING_SIZE bytes
+    void format(char *out) const;
+    [[nodiscard]] std::array<char, STRING_SIZE> toChars() const;
+    [[nodiscard]] std::string toString() const;
+
+    [[nodiscard]] const std::array<uint8_t, 16> &bytes() const { return m_Bytes; }
+    [[nodiscard]] int version() const { return m_Bytes[6] >> 4; }
+    [[nodiscard]] bool isNil() const { return *this == UUID::nil(); }
+
+    // Byte-wise, so v7 UUIDs sort by creation time
+    friend auto operator<=>(const UUID &, const UUID &) = default;
 
 private:
-    unsigned char data[16];
-
-    void generate() {
-        std::random_device rd;
-        std::mt19937 mt(rd());
-        std::uniform_int_distribution<int> dist(0, 255);
-        for (size_t i = 0; i < 16; ++i) {
-            data[i] = static_cast<unsigned char>(dist(mt));
-        }
-        // Set the version and variant bits according to RFC 4122
-        data[6] = (data[6] & 0x0f) | 0x40; // Version 4
-        data[8] = (data[8] & 0x3f) | 0x80; // Variant 10
+    struct NoInit {};
+    explicit UUID(NoInit) {}
+};
+
+template<>
+struct std::hash<UUID> {
+    size_t operator()(const UUID &uuid) const noexcept
+    {
+        // The low 8 bytes are random in both versions
+        uint64_t value = 0;
+        for (size_t i = 8; i < 16; i++)
+            value = value << 8 | uuid.bytes()[i];
+        return static_cast<size_t>(value);
     }
-};
\ No newline at end of file
+};
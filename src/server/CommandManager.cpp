@@ -0,0 +1,122 @@
+//
+// Created by msullivan on 12/14/24.
+//
+
+#include "CommandManager.h"
+#include "commands/Command.h"
+#include "commands/server/help_command/HelpCommand.h"
+#include "commands/server/stop_command/StopCommand.h"
+#include "modules/Logger.h"
+#include "modules/NetworkEngine.h"
+#include "Server.h"
+#include <dlfcn.h>
+
+CommandManager::CommandManager() = default;
+
+CommandManager::~CommandManager()
+{
+    NetworkEngine::receivedData.disconnect(m_Received);
+}
+
+void CommandManager::init()
+{
+    // Built-in commands
+    m_Registry.registerCommand(std::make_unique<HelpCommand>());
+    m_Registry.registerCommand(std::make_unique<StopCommand>());
+
+    m_Received = NetworkEngine::receivedData.connect([this](Connection sender, const std::string &data)
+    {
+        dispatch(sender, data);
+    });
+
+    m_Initialized = true;
+}
+
+void CommandManager::run()
+{
+    m_Active = true;
+    LOG_INFO("CommandManager", "{} command(s) available", m_Registry.size());
+}
+
+std::vector<std::type_index> CommandManager::requiredDependencies() const
+{
+    return {typeid(Logger), typeid(NetworkEngine)};
+}
+
+bool CommandManager::dispatch(Connection sender, std::string_view message)
+{
+    if (message.empty() || message.front() != '/') return false;
+    message.remove_prefix(1);
+
+    size_t separator = message.find(' ');
+    std::string_view name = message.substr(0, separator);
+    std::string_view args = separator != std::string_view::npos ? message.substr(separator + 1) : std::string_view();
+    while (!args.empty() && args.front() == ' ')
+        args.remove_prefix(1);
+
+    Command *command = m_Registry.find(name);
+    if (!command)
+    {
+        NetworkEngine::sendData(sender, "Unknown command: /" + std::string(name) + " (try /help)");
+        return true;
+    }
+
+    if (command->execution() == CommandExecution::Inline)
+    {
+        command->execute(sender, args);
+        return true;
+    }
+
+    // The message is only valid during this call, so the task keeps its own copy of the arguments. Posting
+    // by sender keeps a client's commands in the order it sent them.
+    Server::instance().executor().post(sender, [command, sender, args = std::string(args)]
+    {
+        try
+        {
+            command->execute(sender, args);
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR("CommandManager", "/{} failed: {}", command->name(), e.what());
+        }
+    });
+    return true;
+}
+
+bool CommandManager::loadCommand(const std::string &libPath)
+{
+    void *handle = dlopen(libPath.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle)
+    {
+        LOG_ERROR("CommandManager", "Failed to open library: {}", dlerror());
+        return false;
+    }
+
+    using CommandFactoryFunction = Command *();
+    auto factoryFunction = reinterpret_cast<CommandFactoryFunction *>(dlsym(handle, "importCommand"));
+    if (!factoryFunction)
+    {
+        LOG_ERROR("CommandManager", "Failed to load command: {}", dlerror());
+        dlclose(handle);
+        return false;
+    }
+
+    std::unique_ptr<Command> command(factoryFunction());
+    if (!command)
+    {
+        LOG_ERROR("CommandManager", "Failed to create command instance from {}", libPath);
+        dlclose(handle);
+        return false;
+    }
+
+    // The command's name and code live in the library, which therefore stays open
+    std::string name(command->name());
+    if (!m_Registry.registerCommand(std::move(command)))
+    {
+        LOG_ERROR("CommandManager", "Failed to load command from {}: /{} already exists", libPath, name);
+        dlclose(handle);
+        return false;
+    }
+    LOG_INFO("CommandManager", "Loaded command: /{}", name);
+    return true;
+}
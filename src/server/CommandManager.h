@@ -4,58 +4,31 @@
 
 #pragma once
 #include "commands/CommandRegistry.h"
-#include "modules/Logger.h"
+#include "modules/ServerModule.h"
+#include "Signal.h"
+#include <string>
+#include <string_view>
+
+// Runs slash commands ("/name args") received from clients. Commands are registered during init() and
+// reused for every invocation; resolving one takes no lock and no allocation. Quick commands run on the I/O
+// thread that received them, the rest run on the server's executor, in order for each client.
+class CommandManager : public ServerModule {
+    CommandRegistry m_Registry;
+    SlotHandle m_Received;
 
-#ifndef _WIN32
-#include <dlfcn.h>
-#else
-#endif
-
-class CommandManager {
 public:
-    CommandManager()
-    {
-        std::string commandLibPath = "/home/msullivan/Development/GitHub/ChatApplication/";
-
-        // Load built-in commands
-        //commandRegistry.add("stop", std::make_shared<StopCommand>());
-        //commandRegistry.emplace("help", std::make_shared<HelpCommand>());
-
-        // Load custom commands
-    }
-    ~CommandManager() = default;
-
-    void loadCommand(const std::string &libPath)
-    {
-        void *handle = dlopen(libPath.c_str(), RTLD_LAZY);
-
-        if (!handle)
-        {
-            Logger::log(LogLevel::Error, "Failed to open library: " + std::string(dlerror()));
-            return;
-        }
-
-        using CommandFactoryFunction = Command *();
-        auto factoryFunction = reinterpret_cast<CommandFactoryFunction *>(dlsym(handle, "createCommand"));
-
-        if (!factoryFunction)
-        {
-            Logger::log(LogLevel::Error, "Failed to load command: " + std::string(dlerror()));
-            dlclose(handle);
-            return;
-        }
+    CommandManager();
+    ~CommandManager() override;
+    void init() override;
+    void run() override;
+    [[nodiscard]] std::vector<std::type_index> requiredDependencies() const override;
+    [[nodiscard]] std::vector<std::type_index> optionalDependencies() const override { return {}; }
 
-        auto command = factoryFunction();
-        if (!command)
-        {
-            Logger::log(LogLevel::Error, "Failed to create command instance");
-            dlclose(handle);
-            return;
-        }
+    // Runs the command in a message; returns false if the message is not a command
+    bool dispatch(Connection sender, std::string_view message);
 
-        //std::string commandName = command->name();
+    // Loads a command from a shared library that exports importCommand(); call before the server starts
+    bool loadCommand(const std::string &libPath);
 
-        //registerCommand(commandName, [factoryFunction] { return factoryFunction(); });
-        //Logger::log(LogLevel::Info, "Loaded command: \"" + commandName + '\"');
-    }
-};
\ No newline at end of file
+    [[nodiscard]] const CommandRegistry &registry() const { return m_Registry; }
+};
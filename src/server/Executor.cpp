@@ -0,0 +1,241 @@
+//
+// Created by msullivan on 12/15/24.
+//
+
+#include "Executor.h"
+#include "modules/Logger.h"
+
+// The executor and worker index of the current thread, if it is a worker
+thread_local const Executor *t_Executor = nullptr;
+thread_local size_t t_WorkerIndex = 0;
+
+Executor::Executor(size_t threads) : m_Strands(std::make_unique<Strand[]>(STRAND_COUNT))
+{
+    if (threads == 0) threads = std::max(std::thread::hardware_concurrency(), 1u);
+    for (size_t i = 0; i < threads; i++)
+        m_Workers.emplace_back(std::make_unique<Worker>());
+    for (size_t i = 0; i < threads; i++)
+        m_Threads.emplace_back(&Executor::work, this, i);
+    m_TimerThread = std::jthread(&Executor::runTimers, this);
+}
+
+Executor::~Executor()
+{
+    stop();
+}
+
+void Executor::post(Task task)
+{
+    // A worker keeps its own tasks; other threads deal theirs out in turn
+    size_t index = isWorkerThread() ? t_WorkerIndex : m_NextWorker.fetch_add(1, std::memory_order_relaxed) % m_Workers.size();
+    enqueue(index, std::move(task), false);
+}
+
+// Adds a task to a worker's queue: at the back as its newest task, or at the front behind everything it holds
+void Executor::enqueue(size_t index, Task task, bool oldest)
+{
+    {
+        std::lock_guard lock(m_Workers[index]->mutex);
+        if (oldest)
+            m_Workers[index]->tasks.emplace_front(std::move(task));
+        else
+            m_Workers[index]->tasks.emplace_back(std::move(task));
+    }
+    m_Pending.fetch_add(1);
+    m_Posted.fetch_add(1);
+
+    // Pairs with the sleeper raising m_Sleeping before it checks m_Posted, so one of the two sees the other
+    if (m_Sleeping.load() > 0)
+    {
+        { std::lock_guard lock(m_SleepMutex); }
+        m_SleepCV.notify_one();
+    }
+}
+
+void Executor::post(uint64_t key, Task task)
+{
+    // Mix the key so that neighbouring ones (file descriptors) land on different strands
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    Strand &strand = m_Strands[key % STRAND_COUNT];
+
+    {
+        std::lock_guard lock(strand.mutex);
+        strand.tasks.emplace_back(std::move(task));
+        if (strand.scheduled) return;
+        strand.scheduled = true;
+    }
+    post([this, &strand] { drain(strand); });
+}
+
+void Executor::postAt(Clock::time_point deadline, Task task, std::optional<uint64_t> key)
+{
+    bool earliest;
+    {
+        std::lock_guard lock(m_TimerMutex);
+        earliest = m_Timers.empty() || deadline < m_Timers.top().deadline;
+        m_Timers.push({deadline, m_NextTimer++, key, std::move(task)});
+    }
+    if (earliest) m_TimerCV.notify_one();
+}
+
+void Executor::stop()
+{
+    if (m_Stopping.exchange(true)) return;
+    {
+        std::lock_guard lock(m_SleepMutex);
+    }
+    m_SleepCV.notify_all();
+    {
+        std::lock_guard lock(m_TimerMutex);
+    }
+    m_TimerCV.notify_all();
+    m_TimerThread = {};
+    m_Threads.clear();
+}
+
+bool Executor::isWorkerThread() const
+{
+    return t_Executor == this;
+}
+
+void Executor::work(size_t index)
+{
+    t_Executor = this;
+    t_WorkerIndex = index;
+
+    Task task;
+    size_t spins = 0;
+    while (!m_Stopping.load(std::memory_order_relaxed))
+    {
+        if (take(index, task, false))
+        {
+            run(task);
+            task = nullptr;
+            spins = 0;
+            continue;
+        }
+
+        // Steals skip queues whose lock is busy, so work may still be queued; retry for a little while
+        if (m_Pending.load() > 0 && ++spins < SPIN_LIMIT)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        spins = 0;
+
+        // Before sleeping, look through every queue holding its lock. Anything posted after the
+        // counter is read changes it and ends the wait.
+        uint64_t posted = m_Posted.load();
+        if (take(index, task, true))
+        {
+            run(task);
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock lock(m_SleepMutex);
+        m_Sleeping.fetch_add(1);
+        m_SleepCV.wait(lock, [this, posted] { return m_Stopping.load() || m_Posted.load() != posted; });
+        m_Sleeping.fetch_sub(1);
+    }
+}
+
+// Hands timers to the workers as their deadlines pass
+void Executor::runTimers()
+{
+    std::unique_lock lock(m_TimerMutex);
+    while (!m_Stopping.load())
+    {
+        if (m_Timers.empty())
+        {
+            m_TimerCV.wait(lock);
+            continue;
+        }
+        if (Clock::now() < m_Timers.top().deadline)
+        {
+            m_TimerCV.wait_until(lock, m_Timers.top().deadline);
+            continue;
+        }
+
+        Task task = std::move(m_Timers.top().task);
+        std::optional<uint64_t> key = m_Timers.top().key;
+        m_Timers.pop();
+        lock.unlock();
+        if (key)
+            post(*key, std::move(task));
+        else
+            post(std::move(task));
+        lock.lock();
+    }
+}
+
+// Takes the newest task of this worker's queue, or steals the oldest of another's. Unless wait is set,
+// queues whose lock is held elsewhere are skipped.
+bool Executor::take(size_t index, Task &task, bool wait)
+{
+    {
+        Worker &own = *m_Workers[index];
+        std::lock_guard lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            m_Pending.fetch_sub(1);
+            return true;
+        }
+    }
+
+    for (size_t i = 1; i < m_Workers.size(); i++)
+    {
+        Worker &victim = *m_Workers[(index + i) % m_Workers.size()];
+        std::unique_lock lock(victim.mutex, std::defer_lock);
+        if (wait)
+            lock.lock();
+        else if (!lock.try_lock())
+            continue;
+        if (victim.tasks.empty()) continue;
+
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        m_Pending.fetch_sub(1);
+        return true;
+    }
+
+    return false;
+}
+
+// Runs a strand's tasks in order. After a batch it requeues itself at the front of this worker's queue,
+// which the worker reaches last, so one busy key cannot hold a worker or starve the tasks queued behind it.
+void Executor::drain(Strand &strand)
+{
+    for (size_t i = 0; i < STRAND_BATCH; i++)
+    {
+        Task task;
+        {
+            std::lock_guard lock(strand.mutex);
+            if (strand.tasks.empty())
+            {
+                strand.scheduled = false;
+                return;
+            }
+            task = std::move(strand.tasks.front());
+            strand.tasks.pop_front();
+        }
+        run(task);
+    }
+    enqueue(t_WorkerIndex, [this, &strand] { drain(strand); }, true);
+}
+
+void Executor::run(Task &task)
+{
+    try
+    {
+        task();
+    }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR("Executor", "Task failed: {}", e.what());
+    }
+}
@@ -0,0 +1,110 @@
+//
+// Created by msullivan on 12/15/24.
+//
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool. Each worker keeps its own queue: tasks posted from a worker go to the back of
+// its queue and it takes from the back, while idle workers steal from the front of the others' queues.
+// Tasks posted from other threads are spread over the workers. An idle worker spins briefly and then
+// sleeps until the next post.
+//
+// post(key, task) runs tasks with the same key one at a time, in the order they were posted, through a
+// strand: a serial queue that occupies at most one worker at a time. Keys are hashed onto a fixed set of
+// strands, so unrelated keys may occasionally share one; they stay ordered, just not concurrent.
+//
+// postAt() queues a task once a deadline passes; one timer thread keeps the deadlines.
+class Executor {
+public:
+    using Task = std::function<void()>;
+    using Clock = std::chrono::steady_clock;
+
+private:
+    static constexpr size_t STRAND_COUNT = 256;
+    static constexpr size_t STRAND_BATCH = 32;     // Tasks a strand runs before yielding its worker
+    static constexpr size_t SPIN_LIMIT = 64;       // Failed takes an idle worker yields through before sleeping
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    struct Strand {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        bool scheduled = false;     // A drain is queued or running
+    };
+
+    struct Timer {
+        Clock::time_point deadline;
+        uint64_t sequence;          // Keeps timers with the same deadline in order
+        std::optional<uint64_t> key;
+        mutable Task task;
+
+        bool operator>(const Timer &other) const
+        {
+            return deadline != other.deadline ? deadline > other.deadline : sequence > other.sequence;
+        }
+    };
+
+    std::vector<std::unique_ptr<Worker>> m_Workers;
+    std::unique_ptr<Strand[]> m_Strands;
+    std::atomic<size_t> m_NextWorker = 0;
+    std::atomic<size_t> m_Pending = 0;
+    std::atomic<uint64_t> m_Posted = 0;     // Counts posts; a sleeping worker waits for it to change
+    std::atomic<size_t> m_Sleeping = 0;
+    std::atomic<bool> m_Stopping = false;
+    std::mutex m_SleepMutex;
+    std::condition_variable m_SleepCV;
+    std::vector<std::jthread> m_Threads;
+
+    std::mutex m_TimerMutex;
+    std::condition_variable m_TimerCV;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<>> m_Timers;
+    uint64_t m_NextTimer = 0;
+    std::jthread m_TimerThread;
+
+    void work(size_t index);
+    void runTimers();
+    void enqueue(size_t index, Task task, bool oldest);
+    bool take(size_t index, Task &task, bool wait);
+    void drain(Strand &strand);
+    void run(Task &task);
+
+public:
+    // Starts the workers; 0 means one per core
+    explicit Executor(size_t threads = 0);
+    ~Executor();
+
+    Executor(const Executor &) = delete;
+    Executor &operator=(const Executor &) = delete;
+
+    // Queues a task
+    void post(Task task);
+
+    // Queues a task behind every earlier task with the same key
+    void post(uint64_t key, Task task);
+
+    // Queues a task once the deadline has passed, behind earlier tasks with the same key if one is given
+    void postAt(Clock::time_point deadline, Task task, std::optional<uint64_t> key = std::nullopt);
+
+    // Stops the workers once their current tasks return; queued tasks and pending timers are dropped
+    void stop();
+
+    [[nodiscard]] size_t threads() const { return m_Workers.size(); }
+
+    // True on one of this executor's workers
+    [[nodiscard]] bool isWorkerThread() const;
+};
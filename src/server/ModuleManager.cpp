@@ -0,0 +1,208 @@
+//
+// Created by msullivan on 12/12/24.
+//
+
+#include "ModuleManager.h"
+#include "modules/Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+// Edges between registered modules; optional dependencies that are not registered are left out
+struct DependencyGraph {
+    std::vector<std::type_index> order;                                             // Every module
+    std::unordered_map<std::type_index, size_t> unmet;                              // Dependencies not initialized yet
+    std::unordered_map<std::type_index, std::vector<std::type_index>> dependencies;
+    std::unordered_map<std::type_index, std::vector<std::type_index>> dependents;
+};
+
+std::string ModuleManager::typeName(std::type_index type)
+{
+#ifdef __GNUG__
+    int status = 0;
+    std::unique_ptr<char, decltype(&std::free)> name(abi::__cxa_demangle(type.name(), nullptr, nullptr, &status), &std::free);
+    if (status == 0 && name) return name.get();
+#endif
+    return type.name();
+}
+
+bool ModuleManager::initializeModules()
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    // Build the dependency graph and a topological order while holding the lock, then initialize without it
+    // so modules may look each other up from init()
+    DependencyGraph graph;
+    std::unordered_map<std::type_index, std::shared_ptr<ServerModule>> modules;
+    std::unordered_map<std::type_index, std::string> names;
+    {
+        std::lock_guard lock(m_Mutex);
+        bool valid = true;
+        for (const auto &[type, module] : m_Modules)
+        {
+            graph.order.emplace_back(type);
+            auto &dependencies = graph.dependencies[type];
+            for (const auto &dependency : module->requiredDependencies())
+            {
+                if (m_Modules.contains(dependency))
+                    dependencies.emplace_back(dependency);
+                else
+                {
+                    LOG_ERROR("ModuleManager", "{} requires {}, which is not registered", nameOf(type), typeName(dependency));
+                    valid = false;
+                }
+            }
+            for (const auto &dependency : module->optionalDependencies())
+                if (m_Modules.contains(dependency))
+                    dependencies.emplace_back(dependency);
+        }
+        if (!valid) return false;
+
+        for (const auto &[type, dependencies] : graph.dependencies)
+        {
+            graph.unmet[type] = dependencies.size();
+            for (const auto &dependency : dependencies)
+                graph.dependents[dependency].emplace_back(type);
+        }
+
+        m_Order.clear();
+        if (!resolveOrder(graph)) return false;
+        modules = m_Modules;
+        names = m_Names;
+    }
+
+    if (modules.empty()) return true;
+
+    // Workers take modules whose dependencies are initialized; finishing one may make its dependents ready
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::type_index> ready;
+    size_t remaining = modules.size();
+    bool failed = false;
+    for (const auto &type : m_Order)
+        if (graph.unmet[type] == 0)
+            ready.emplace_back(type);
+
+    auto worker = [&]
+    {
+        std::unique_lock lock(mutex);
+        while (true)
+        {
+            changed.wait(lock, [&] { return failed || remaining == 0 || !ready.empty(); });
+            if (failed || remaining == 0) return;
+
+            std::type_index type = ready.front();
+            ready.pop_front();
+            lock.unlock();
+
+            auto &module = modules.at(type);
+            auto moduleStart = std::chrono::steady_clock::now();
+            bool initialized = false;
+            try
+            {
+                module->init();
+                initialized = module->isInitialized();
+                if (!initialized)
+                    LOG_ERROR("ModuleManager", "{} failed to initialize", names.at(type));
+            }
+            catch (const std::exception &e)
+            {
+                LOG_ERROR("ModuleManager", "{} failed to initialize: {}", names.at(type), e.what());
+            }
+            auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - moduleStart);
+
+            lock.lock();
+            if (initialized)
+            {
+                LOG_INFO("ModuleManager", "Initialized {} in {} us", names.at(type), elapsed.count());
+                remaining--;
+                for (const auto &dependent : graph.dependents[type])
+                    if (--graph.unmet[dependent] == 0)
+                        ready.emplace_back(dependent);
+            }
+            else
+                failed = true;
+            changed.notify_all();
+        }
+    };
+
+    {
+        size_t threads = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, modules.size());
+        std::vector<std::jthread> pool;
+        for (size_t i = 0; i < threads; i++)
+            pool.emplace_back(worker);
+    }
+    if (failed) return false;
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime);
+    LOG_INFO("ModuleManager", "Initialized {} module(s) in {} us", modules.size(), elapsed.count());
+    return true;
+}
+
+void ModuleManager::startModules()
+{
+    std::lock_guard lock(m_Mutex);
+    std::vector<std::type_index> order = m_Order;
+    if (order.size() != m_Modules.size())
+    {
+        // initializeModules() did not run or failed; start in no particular order
+        order.clear();
+        for (const auto &[type, module] : m_Modules)
+            order.emplace_back(type);
+    }
+
+    for (const auto &type : order)
+    {
+        auto start = std::chrono::steady_clock::now();
+        m_Modules.at(type)->run();
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        LOG_INFO("ModuleManager", "Started {} in {} us", nameOf(type), elapsed.count());
+    }
+}
+
+// Fills m_Order with every module after its dependencies (Kahn's algorithm); reports a cycle if there is one.
+// The caller holds m_Mutex.
+bool ModuleManager::resolveOrder(const DependencyGraph &graph)
+{
+    std::unordered_map<std::type_index, size_t> unmet = graph.unmet;
+    std::deque<std::type_index> ready;
+    for (const auto &type : graph.order)
+        if (unmet.at(type) == 0)
+            ready.emplace_back(type);
+
+    while (!ready.empty())
+    {
+        std::type_index type = ready.front();
+        ready.pop_front();
+        m_Order.emplace_back(type);
+
+        if (auto it = graph.dependents.find(type); it != graph.dependents.end())
+            for (const auto &dependent : it->second)
+                if (--unmet.at(dependent) == 0)
+                    ready.emplace_back(dependent);
+    }
+    if (m_Order.size() == graph.order.size()) return true;
+
+    // Every module left waits on another one that is left; following those leads around a cycle
+    std::vector<std::type_index> path;
+    std::type_index current = *std::ranges::find_if(graph.order, [&](const auto &type) { return unmet.at(type) > 0; });
+    while (std::ranges::find(path, current) == path.end())
+    {
+        path.emplace_back(current);
+        const auto &dependencies = graph.dependencies.at(current);
+        current = *std::ranges::find_if(dependencies, [&](const auto &type) { return unmet.at(type) > 0; });
+    }
+
+    std::string cycle;
+    for (auto it = std::ranges::find(path, current); it != path.end(); ++it)
+        cycle += nameOf(*it) + " -> ";
+    cycle += nameOf(current);
+    LOG_ERROR("ModuleManager", "Module dependencies form a cycle: {}", cycle);
+    m_Order.clear();
+    return false;
+}
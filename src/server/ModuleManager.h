@@ -5,15 +5,46 @@
 #pragma once
 #include "modules/ServerModule.h"
 #include <unordered_map>
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <typeindex>
+#include <typeinfo>
 #include <optional>
+#include <stdexcept>
+#include <vector>
+
+struct DependencyGraph;
+
+// Most module types a server can have; also bounds the lookup table
+constexpr size_t MAX_MODULE_TYPES = 64;
+
+inline std::atomic<size_t> g_NextModuleTypeID = 0;
+
+// Dense id of a module type, assigned the first time the type is looked up or registered
+template <typename T>
+size_t moduleTypeID()
+{
+    static const size_t id = g_NextModuleTypeID.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
 
 class ModuleManager {
     std::unordered_map<std::type_index, std::shared_ptr<ServerModule>> m_Modules;
+    std::unordered_map<std::type_index, std::string> m_Names;
+    std::vector<std::type_index> m_Order;   // Dependencies before dependents; set by initializeModules()
     std::mutex m_Mutex;
 
+    // Each registered module by moduleTypeID(), already cast to its own type; read without locking
+    std::array<std::atomic<void *>, MAX_MODULE_TYPES> m_Lookup {};
+    std::atomic<bool> m_Frozen = false;
+
+    bool resolveOrder(const DependencyGraph &graph);
+    [[nodiscard]] const std::string &nameOf(std::type_index type) const { return m_Names.at(type); }
+
 public:
     static ModuleManager &instance()
     {
@@ -21,25 +52,44 @@ public:
         return instance;
     }
 
+    // Readable name of a type, e.g. "NetworkEngine"
+    static std::string typeName(std::type_index type);
+
     template <typename T, typename... Args>
     void registerModule(Args &&... args)
     {
         std::lock_guard lock(m_Mutex);
         const auto type = std::type_index(typeid(T));
 
+        if (m_Frozen.load(std::memory_order_relaxed))
+            throw std::runtime_error("Modules cannot be registered after startup.");
         if (m_Modules.contains(type))
             throw std::runtime_error("Module of this type is already registered.");
+        if (moduleTypeID<T>() >= MAX_MODULE_TYPES)
+            throw std::runtime_error("Too many module types.");
 
-        m_Modules[type] = std::make_shared<T>(std::forward<Args>(args)...);
+        auto module = std::make_shared<T>(std::forward<Args>(args)...);
+        m_Lookup[moduleTypeID<T>()].store(module.get(), std::memory_order_release);
+        m_Modules[type] = std::move(module);
+        m_Names[type] = typeName(typeid(T));
     }
 
-    // Retrieve a module by type
+    // Retrieve a module by type without locking or RTTI; nullptr if it is not registered. Modules live until
+    // the manager is destroyed, so the pointer can be kept. This is the lookup for request paths.
+    template <typename T>
+    T *findModule() const
+    {
+        size_t id = moduleTypeID<T>();
+        return id < MAX_MODULE_TYPES ? static_cast<T *>(m_Lookup[id].load(std::memory_order_acquire)) : nullptr;
+    }
+
+    // Retrieve a module by type, sharing ownership
     template <typename T>
     std::shared_ptr<T> getModule()
     {
         std::lock_guard lock(m_Mutex);
-        const auto type = std::type_index(typeid(T));
-        return m_Modules.contains(type) ? std::dynamic_pointer_cast<T>(m_Modules[type]) : nullptr;
+        auto it = m_Modules.find(std::type_index(typeid(T)));
+        return it != m_Modules.end() ? std::static_pointer_cast<T>(it->second) : nullptr;
     }
 
     // Retrieve a module by type (optional, for optional dependencies)
@@ -47,22 +97,17 @@ public:
     std::optional<std::shared_ptr<T>> getOptionalModule()
     {
         auto module = getModule<T>();
-        return module ? module : std::nullopt;
+        return module ? std::optional(module) : std::nullopt;
     }
 
-    // Initialize all registered modules
-    void initializeModules()
-    {
-        std::lock_guard lock(m_Mutex);
-        for (auto &[type, module] : m_Modules)
-            module->init();
-    }
+    // Initialize all registered modules after their dependencies, running independent ones concurrently.
+    // Returns false if a required dependency is missing, the dependencies form a cycle or a module failed.
+    bool initializeModules();
 
-    // Start all registered and initialized modules
-    void startModules()
-    {
-        std::lock_guard lock(m_Mutex);
-        for (auto &[type, module] : m_Modules)
-            module->run();
-    }
+    // Start all registered and initialized modules, dependencies first
+    void startModules();
+
+    // Ends startup: no module can be registered afterward
+    void freeze() { m_Frozen.store(true, std::memory_order_release); }
+    [[nodiscard]] bool isFrozen() const { return m_Frozen.load(std::memory_order_acquire); }
 };
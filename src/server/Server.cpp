@@ -7,11 +7,15 @@
 #include "ModuleManager.h"
 #include "modules/NetworkEngine.h"
 #include "modules/Logger.h"
+#include "modules/ModuleLoader.h"
+#include "CommandManager.h"
 #include <getopt.h>
 #include <filesystem>
+#include <optional>
 
 // Forward declaration(s)
 void printUsage();
+std::optional<LogLevel> parseLogLevel(const std::string &name);
 
 // Static variables
 std::string g_WorkingDirectory;
@@ -23,6 +27,12 @@ int init(int, char **);
 Server::Server() : m_Running(false), m_Daemonized(false)
 {}
 
+Server &Server::instance()
+{
+    static Server server;
+    return server;
+}
+
 int Server::run(int argc, char **argv)
 {
     int initResult = init(argc, argv);
@@ -34,6 +44,9 @@ int Server::run(int argc, char **argv)
     g_ServerCV.wait(lock, [this] {
         return !m_Running;
     });
+
+    // Tasks may use any module, so they must finish before the modules are destroyed
+    m_Executor.stop();
     return 0;
 }
 
@@ -71,8 +84,7 @@ std::optional<std::shared_ptr<T>> Server::getOptionalModule()
 template<typename T>
 bool Server::isModuleLoaded()
 {
-    auto module = ModuleManager::instance().getModule<T>();
-    return module ? true : false;
+    return ModuleManager::instance().findModule<T>() != nullptr;
 }
 
 int init(int argc, char **argv)
@@ -92,12 +104,60 @@ int init(int argc, char **argv)
     }
 
     // 2. Parse command-line arguments
+    NetworkConfig networkConfig;
+    LoggerConfig loggerConfig;
+    ModuleLoaderConfig loaderConfig;
     int opt;
-    while ((opt = getopt(argc, argv, "p:h")) != -1)
+    while ((opt = getopt(argc, argv, "p:w:b:t:k:l:m:B:M:h")) != -1)
         switch (opt)
         {
             case 'p':
-                //port = std::stoi(optarg);
+                networkConfig.port = std::stoi(optarg);
+            break;
+            case 'w':
+                networkConfig.workers = std::stoul(optarg);
+            break;
+            case 'b':
+                networkConfig.backlog = std::stoi(optarg);
+            break;
+            case 't':
+                networkConfig.idleTimeout = std::stoi(optarg);
+            break;
+            case 'k':
+                networkConfig.keepaliveTimeout = std::stoi(optarg);
+            break;
+            case 'l':
+            {
+                auto level = parseLogLevel(optarg);
+                if (!level)
+                {
+                    printUsage();
+                    return -1;
+                }
+                loggerConfig.level = *level;
+                Logger::setLevel(*level);
+            }
+            break;
+            case 'm':
+            {
+                // module=level
+                std::string argument = optarg;
+                size_t separator = argument.find('=');
+                auto level = separator == std::string::npos ? std::nullopt : parseLogLevel(argument.substr(separator + 1));
+                if (!level)
+                {
+                    printUsage();
+                    return -1;
+                }
+                loggerConfig.moduleLevels.emplace_back(argument.substr(0, separator), *level);
+            }
+            break;
+            case 'B':
+                loggerConfig.sink = LogSink::Binary;
+                loggerConfig.binaryPath = optarg;
+            break;
+            case 'M':
+                loaderConfig.paths.emplace_back(optarg);
             break;
             case 'h':
                 printUsage();
@@ -109,16 +169,41 @@ int init(int argc, char **argv)
         }
 
     // 8. Add and initialize built-in modules
-    ModuleManager::instance().registerModule<Logger>();
-    ModuleManager::instance().registerModule<NetworkEngine>();
-    ModuleManager::instance().initializeModules();
+    ModuleManager::instance().registerModule<Logger>(loggerConfig);
+    ModuleManager::instance().registerModule<NetworkEngine>(networkConfig);
+    ModuleManager::instance().registerModule<ModuleLoader>(loaderConfig);
+    ModuleManager::instance().registerModule<CommandManager>();
+    if (!ModuleManager::instance().initializeModules())
+    {
+        Logger::log(LogLevel::Fatal, "Failed to initialize modules");
+        return -1;
+    }
     ModuleManager::instance().startModules();
+    ModuleManager::instance().freeze();
     return 0;
 }
 
 void printUsage()
 {
-    std::cout << "Usage: program [-p port]" << std::endl;
+    std::cout << "Usage: program [-p port] [-w workers] [-b backlog] [-t seconds] [-k seconds] [-l level] [-m module=level] [-B path] [-M library]" << std::endl;
     std::cout << "  -p port        Specify the port number" << std::endl;
+    std::cout << "  -w workers     Number of I/O worker threads (default: one per core)" << std::endl;
+    std::cout << "  -b backlog     Accept queue length per listener (default: 4096)" << std::endl;
+    std::cout << "  -t seconds     Disconnect clients idle for this long; 0 disables (default: 30)" << std::endl;
+    std::cout << "  -k seconds     TCP keepalive timeout for silent peers; 0 uses the system default (default: 60)" << std::endl;
+    std::cout << "  -l level       Minimum log level: debug, info, warning, error or fatal (default: info)" << std::endl;
+    std::cout << "  -m module=level  Log level for one module, e.g. -m NetworkEngine=debug; may be repeated" << std::endl;
+    std::cout << "  -B path        Write binary logs to path.<n> instead of text to stdout; read them with logdecoder" << std::endl;
+    std::cout << "  -M library     Load a module from a shared library; reloaded when the file changes. May be repeated" << std::endl;
     std::cout << "  -h             Display this help message" << std::endl;
+}
+
+std::optional<LogLevel> parseLogLevel(const std::string &name)
+{
+    if (name == "debug") return LogLevel::Debug;
+    if (name == "info") return LogLevel::Info;
+    if (name == "warning") return LogLevel::Warning;
+    if (name == "error") return LogLevel::Error;
+    if (name == "fatal") return LogLevel::Fatal;
+    return std::nullopt;
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 
 #pragma once
 #include "Signal.h"
+#include "Executor.h"
 #include "ModuleManager.h"
 #include "CommandManager.h"
 #include <atomic>
@@ -31,11 +32,15 @@ public signals:
 private:
     std::atomic<bool> m_Running;
     bool m_Daemonized;
+    Executor m_Executor;
 
 public:
     Server();
     virtual ~Server() = default;
 
+    // The server of this process
+    static Server &instance();
+
     // Delete copy constructor and assignment operators
     Server(const Server &) = delete;
     Server(Server &&) = delete;
@@ -54,6 +59,9 @@ public:
     // Returns true if the server is daemonized
     [[nodiscard]] bool isDaemonized() const { return m_Daemonized; }
 
+    // Returns the thread pool for work that should not run on the I/O threads
+    [[nodiscard]] Executor &executor() { return m_Executor; }
+
     // Returns the current working directory
     [[nodiscard]] std::string workingDirectory() const;
 
@@ -3,41 +3,267 @@
 //
 
 #pragma once
+#include "Executor.h"
 #include <vector>
 #include <mutex>
-#include <functional>
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <string>
+#include <string_view>
+#include <algorithm>
 
+// Type-erased callable with inline storage. Function pointers and small lambdas are stored in place;
+// only larger callables are boxed on the heap, once, when the slot is connected. Slots are always
+// invoked with lvalues so every slot of a signal sees the same arguments.
+template<typename... Args>
+class Delegate {
+    static constexpr size_t INLINE_SIZE = 4 * sizeof(void *);
+
+    using Invoker = void (*)(const void *, Args &...);
+    using Destroyer = void (*)(void *);
+
+    alignas(std::max_align_t) std::byte m_Storage[INLINE_SIZE];
+    Invoker m_Invoke = nullptr;
+    Destroyer m_Destroy = nullptr;
+
+public:
+    template<typename Callable>
+    explicit Delegate(Callable &&callable)
+    {
+        using Stored = std::decay_t<Callable>;
+        if constexpr (sizeof(Stored) <= INLINE_SIZE && alignof(Stored) <= alignof(std::max_align_t))
+        {
+            new (m_Storage) Stored(std::forward<Callable>(callable));
+            m_Invoke = [](const void *storage, Args &... args)
+            {
+                (*const_cast<Stored *>(static_cast<const Stored *>(storage)))(args...);
+            };
+            m_Destroy = [](void *storage) { static_cast<Stored *>(storage)->~Stored(); };
+        }
+        else
+        {
+            new (m_Storage) Stored *(new Stored(std::forward<Callable>(callable)));
+            m_Invoke = [](const void *storage, Args &... args)
+            {
+                (**static_cast<Stored *const *>(storage))(args...);
+            };
+            m_Destroy = [](void *storage) { delete *static_cast<Stored **>(storage); };
+        }
+    }
+
+    ~Delegate() { m_Destroy(m_Storage); }
+
+    Delegate(const Delegate &) = delete;
+    Delegate &operator=(const Delegate &) = delete;
+
+    void operator()(Args &... args) const { m_Invoke(m_Storage, args...); }
+};
+
+// Whether the first of a signal's arguments is integral, i.e. usable as an ordering key
+template<typename... Args>
+struct FirstIsIntegral : std::false_type {};
+template<typename First, typename... Rest>
+struct FirstIsIntegral<First, Rest...> : std::is_integral<std::decay_t<First>> {};
+
+// How connectAsync() stores an argument: views are copied into the string they view, since what they point
+// at (e.g. a reactor's frame arena) may be gone by the time the task runs. Allocator-aware types such as
+// Message need nothing here; their copies are made on the default resource.
+template<typename T>
+struct AsyncArgument { using type = std::decay_t<T>; };
+template<>
+struct AsyncArgument<std::string_view> { using type = std::string; };
+
+// Identifies one connection of a slot to a signal
+struct SlotHandle {
+    uint64_t id = 0;
+    explicit operator bool() const { return id != 0; }
+};
+
+// Stripe of a signal's reader counters that the calling thread uses; fixed per thread
+inline size_t signalReaderStripe()
+{
+    static std::atomic<size_t> s_NextStripe {0};
+    thread_local size_t stripe = s_NextStripe.fetch_add(1, std::memory_order_relaxed);
+    return stripe;
+}
+
+// Emitting takes no lock and does not allocate: it walks an immutable slot list published through an
+// atomic pointer. connect() and disconnect() copy the list, publish the copy and retire the old one.
+//
+// Emitters announce themselves in striped reader counters while they walk a list. Retired lists and
+// disconnected slots are freed once every counter reads zero: by the writer right after it publishes, or
+// otherwise by the next emit that finds the signal quiescent. An emit that loaded a retired list was counted
+// before that list was unpublished, so nothing it walks is freed under it. Slots may emit, connect or
+// disconnect from within a slot; the outer emit keeps everything alive until it returns.
 template<typename... Args>
 class Signal {
+    struct Slot {
+        uint64_t id;
+        Delegate<Args...> delegate;
+    };
+    using SlotList = std::vector<const Slot *>;
+
+    static constexpr size_t READER_STRIPES = 8;
+    struct alignas(64) ReaderStripe {
+        std::atomic<uint32_t> count {0};
+    };
+
+    std::atomic<const SlotList *> m_Slots {nullptr};
+    ReaderStripe m_Readers[READER_STRIPES];
+    std::atomic<bool> m_HasRetired {false};
+
+    // Writers only
     std::mutex m_Mutex;
-    std::vector<std::function<void(Args...)>> m_Slots;
+    uint64_t m_NextID = 1;
+    std::unique_ptr<const SlotList> m_Published;                // The list m_Slots points to
+    std::vector<std::unique_ptr<Slot>> m_Connected;             // Slots in the published list
+    std::vector<std::unique_ptr<const SlotList>> m_RetiredLists;
+    std::vector<std::unique_ptr<Slot>> m_RetiredSlots;
+
+    // Counts the calling thread as a reader of the published list for its lifetime
+    class ReadGuard {
+        Signal &m_Signal;
+        std::atomic<uint32_t> &m_Count;
+
+    public:
+        explicit ReadGuard(Signal &signal)
+                : m_Signal(signal), m_Count(signal.m_Readers[signalReaderStripe() % READER_STRIPES].count)
+        {
+            m_Count.fetch_add(1, std::memory_order_seq_cst);
+        }
+
+        ~ReadGuard()
+        {
+            m_Count.fetch_sub(1, std::memory_order_seq_cst);
+            if (m_Signal.m_HasRetired.load(std::memory_order_seq_cst)) [[unlikely]]
+            {
+                // Never wait on a writer from the emit path; if one holds the lock, it reclaims itself
+                std::unique_lock lock(m_Signal.m_Mutex, std::try_to_lock);
+                if (lock) m_Signal.reclaim();
+            }
+        }
+
+        ReadGuard(const ReadGuard &) = delete;
+        ReadGuard &operator=(const ReadGuard &) = delete;
+    };
+
+    // Publishes a new slot list and retires the old one. The caller holds m_Mutex.
+    void publish(SlotList list)
+    {
+        auto next = std::make_unique<const SlotList>(std::move(list));
+        m_Slots.store(next.get(), std::memory_order_seq_cst);
+        if (m_Published)
+        {
+            m_RetiredLists.emplace_back(std::move(m_Published));
+            m_HasRetired.store(true, std::memory_order_seq_cst);
+        }
+        m_Published = std::move(next);
+        reclaim();
+    }
+
+    // Frees retired lists and slots if no emit is running. The caller holds m_Mutex.
+    void reclaim()
+    {
+        if (m_RetiredLists.empty() && m_RetiredSlots.empty()) return;
+        for (const ReaderStripe &stripe : m_Readers)
+            if (stripe.count.load(std::memory_order_seq_cst) != 0) return;
+
+        m_HasRetired.store(false, std::memory_order_relaxed);
+        m_RetiredLists.clear();
+        m_RetiredSlots.clear();
+    }
+
+    [[nodiscard]] SlotList current() const
+    {
+        return m_Published ? *m_Published : SlotList {};
+    }
 
 public:
+    Signal() = default;
+    Signal(const Signal &) = delete;
+    Signal &operator=(const Signal &) = delete;
+
     // Connect a slot to a signal
-    template <typename Slot>
-    void connect(Slot&& slot)
+    template <typename Callable>
+    SlotHandle connect(Callable &&callable)
     {
         std::lock_guard lock(m_Mutex);
-        m_Slots.emplace_back(std::forward<Slot>(slot));
+        auto &slot = m_Connected.emplace_back(new Slot {m_NextID++, Delegate<Args...>(std::forward<Callable>(callable))});
+
+        SlotList list = current();
+        list.emplace_back(slot.get());
+        publish(std::move(list));
+        return SlotHandle {slot->id};
     }
 
-    // Disconnect a specific slot
-    template <typename Slot>
-    void disconnect(Slot&& slot)
+    // Connect a slot that runs on an executor instead of the emitting thread. It receives copies of the
+    // arguments. If the first argument is integral (such as a Connection), calls with the same first argument
+    // run one at a time in emission order; otherwise calls may run concurrently and in any order.
+    template <typename Callable>
+    SlotHandle connectAsync(Executor &executor, Callable &&callable)
+    {
+        auto target = std::make_shared<std::decay_t<Callable>>(std::forward<Callable>(callable));
+        return connect([&executor, target](Args &... args)
+        {
+            auto task = [target, arguments = std::tuple<typename AsyncArgument<std::decay_t<Args>>::type...>(args...)]() mutable
+            {
+                std::apply(*target, arguments);
+            };
+            if constexpr (FirstIsIntegral<Args...>::value)
+                executor.post(static_cast<uint64_t>(std::get<0>(std::tie(args...))), std::move(task));
+            else
+                executor.post(std::move(task));
+        });
+    }
+
+    // Disconnect the slot a handle refers to; returns false if it was not connected
+    bool disconnect(SlotHandle handle)
+    {
+        std::lock_guard lock(m_Mutex);
+        auto it = std::find_if(m_Connected.begin(), m_Connected.end(),
+                               [&](const std::unique_ptr<Slot> &slot) { return slot->id == handle.id; });
+        if (it == m_Connected.end()) return false;
+
+        SlotList list = current();
+        std::erase(list, it->get());
+        m_RetiredSlots.emplace_back(std::move(*it));
+        m_Connected.erase(it);
+        publish(std::move(list));
+        return true;
+    }
+
+    // Disconnect every slot
+    void disconnectAll()
     {
         std::lock_guard lock(m_Mutex);
-        m_Slots.erase(std::remove_if(m_Slots.begin(), m_Slots.end(),
-            [&](const std::function<void()>& storedSlot) {
-                return storedSlot.target_type() == typeid(slot);
-            }), m_Slots.end());
+        for (auto &slot : m_Connected)
+            m_RetiredSlots.emplace_back(std::move(slot));
+        m_Connected.clear();
+        publish({});
+    }
+
+    [[nodiscard]] size_t size()
+    {
+        ReadGuard guard(*this);
+        const SlotList *list = m_Slots.load(std::memory_order_seq_cst);
+        return list ? list->size() : 0;
     }
 
     // Emit the signal (invoke all connected slots)
     void emit(Args &&... args)
     {
-        std::lock_guard lock(m_Mutex);
-        for (auto& slot : m_Slots)
-            slot(std::forward<Args>(args)...);
+        ReadGuard guard(*this);
+        const SlotList *list = m_Slots.load(std::memory_order_seq_cst);
+        if (!list) return;
+
+        for (const Slot *slot : *list)
+            slot->delegate(args...);
     }
 
     // Operator() to emit the signal
@@ -49,4 +275,4 @@ public:
 
 // Macros
 #define signals
-#define slots
\ No newline at end of file
+#define slots
@@ -0,0 +1,180 @@
+//
+// Created by msullivan on 12/16/24.
+//
+
+#pragma once
+#include "Executor.h"
+#include "modules/Logger.h"
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+// Coroutines for multi-step exchanges (handshakes, request/response) written as sequential code without a
+// thread per client. A Task starts when it is awaited and resumes its awaiter when it finishes; spawn()
+// starts one that nobody awaits. Awaitables resume coroutines on an Executor, never on the I/O threads.
+//
+//     Task<> login(AsyncConnection connection)
+//     {
+//         co_await connection.write("Username?");
+//         auto username = co_await connection.read(std::chrono::seconds(30));
+//         if (!username) co_return;
+//         ...
+//     }
+//
+//     spawn(login(AsyncConnection(client, Server::instance().executor())));
+
+template<typename T = void>
+class Task;
+
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation = std::noop_coroutine();
+    std::exception_ptr exception;
+
+    // Hands control straight to the awaiter, so chains of tasks do not grow the stack
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+        {
+            return handle.promise().continuation;
+        }
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { exception = std::current_exception(); }
+};
+
+template<typename T>
+struct TaskPromise : TaskPromiseBase {
+    std::optional<T> value;
+
+    Task<T> get_return_object();
+    void return_value(T result) { value.emplace(std::move(result)); }
+    T result()
+    {
+        if (exception) std::rethrow_exception(exception);
+        return std::move(*value);
+    }
+};
+
+template<>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<> get_return_object();
+    void return_void() {}
+    void result()
+    {
+        if (exception) std::rethrow_exception(exception);
+    }
+};
+
+template<typename T>
+class [[nodiscard]] Task {
+public:
+    using promise_type = TaskPromise<T>;
+
+private:
+    std::coroutine_handle<promise_type> m_Handle;
+
+public:
+    explicit Task(std::coroutine_handle<promise_type> handle) : m_Handle(handle) {}
+    Task(Task &&other) noexcept : m_Handle(std::exchange(other.m_Handle, nullptr)) {}
+    Task &operator=(Task &&other) noexcept
+    {
+        if (this != &other)
+        {
+            if (m_Handle) m_Handle.destroy();
+            m_Handle = std::exchange(other.m_Handle, nullptr);
+        }
+        return *this;
+    }
+    ~Task()
+    {
+        if (m_Handle) m_Handle.destroy();
+    }
+
+    bool await_ready() const noexcept { return !m_Handle || m_Handle.done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept
+    {
+        m_Handle.promise().continuation = awaiter;
+        return m_Handle;
+    }
+    T await_resume() { return m_Handle.promise().result(); }
+};
+
+template<typename T>
+Task<T> TaskPromise<T>::get_return_object()
+{
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<> TaskPromise<void>::get_return_object()
+{
+    return Task<>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+// Runs on the calling thread until its first suspension and frees itself when it finishes
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// Starts a task that nobody awaits; an exception it lets escape is logged
+inline DetachedTask spawn(Task<> task)
+{
+    try
+    {
+        co_await task;
+    }
+    catch (const std::exception &e)
+    {
+        LOG_ERROR("Task", "Unhandled exception: {}", e.what());
+    }
+}
+
+// Moves the coroutine onto an executor; with a key it runs behind earlier tasks for that key
+struct ScheduleAwaitable {
+    Executor &executor;
+    std::optional<uint64_t> key;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) const
+    {
+        if (key)
+            executor.post(*key, [handle] { handle.resume(); });
+        else
+            executor.post([handle] { handle.resume(); });
+    }
+    void await_resume() const noexcept {}
+};
+
+inline ScheduleAwaitable schedule(Executor &executor, std::optional<uint64_t> key = std::nullopt)
+{
+    return {executor, key};
+}
+
+// Suspends the coroutine for a while and resumes it on an executor
+struct SleepAwaitable {
+    Executor &executor;
+    Executor::Clock::time_point deadline;
+    std::optional<uint64_t> key;
+
+    bool await_ready() const noexcept { return Executor::Clock::now() >= deadline; }
+    void await_suspend(std::coroutine_handle<> handle) const
+    {
+        executor.postAt(deadline, [handle] { handle.resume(); }, key);
+    }
+    void await_resume() const noexcept {}
+};
+
+inline SleepAwaitable sleepFor(Executor &executor, Executor::Clock::duration duration, std::optional<uint64_t> key = std::nullopt)
+{
+    return {executor, Executor::Clock::now() + duration, key};
+}
@@ -3,12 +3,21 @@
 //
 
 #pragma once
-#include <string>
+#include "server/modules/ServerModule.h"
+#include <string_view>
 
+// Where CommandManager runs a command
+enum class CommandExecution {
+    Inline, // On the I/O thread that received it; for quick commands
+    Worker  // On a command worker thread; for anything that may block
+};
+
+// A slash command. One instance serves every invocation, possibly on several threads at once.
 class Command {
 public:
     virtual ~Command() = default;
-    virtual void execute(const std::string &args) = 0;
-    [[nodiscard]] constexpr virtual std::string name() const = 0;
-    [[nodiscard]] constexpr virtual std::string usage() const = 0;
-};
\ No newline at end of file
+    virtual void execute(Connection sender, std::string_view args) = 0;
+    [[nodiscard]] virtual std::string_view name() const = 0;
+    [[nodiscard]] virtual std::string_view usage() const = 0;
+    [[nodiscard]] virtual CommandExecution execution() const { return CommandExecution::Inline; }
+};
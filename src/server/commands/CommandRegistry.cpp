@@ -3,15 +3,24 @@
 //
 
 #include "CommandRegistry.h"
+#include "Command.h"
+#include <algorithm>
 
-void CommandRegistry::registerCommand(const std::string &name, const CommandFactory &factory)
+CommandRegistry::CommandRegistry() = default;
+CommandRegistry::~CommandRegistry() = default;
+
+bool CommandRegistry::registerCommand(std::unique_ptr<Command> command)
 {
-    m_CommandFactories[name] = factory;
+    std::string_view name = command->name();
+    auto it = std::ranges::lower_bound(m_Commands, name, {}, &Entry::name);
+    if (it != m_Commands.end() && it->name == name) return false;
+
+    m_Commands.insert(it, Entry {name, std::move(command)});
+    return true;
 }
 
-Command *CommandRegistry::createCommand(const std::string& name)
+Command *CommandRegistry::find(std::string_view name) const
 {
-    if (m_CommandFactories.find(name) != m_CommandFactories.end())
-        return m_CommandFactories[name]();
-    throw std::runtime_error("Command not found: " + name);
-}
\ No newline at end of file
+    auto it = std::ranges::lower_bound(m_Commands, name, {}, &Entry::name);
+    return it != m_Commands.end() && it->name == name ? it->command.get() : nullptr;
+}
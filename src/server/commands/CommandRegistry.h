@@ -3,26 +3,36 @@
 //
 
 #pragma once
-#include <string>
-#include <unordered_map>
-#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
 
 // Forward declaration(s)
 class Command;
 
-using CommandFactory = std::function<Command *()>;
-
+// Commands by name in a sorted flat map. Commands are added during startup; lookups take no lock and
+// do not allocate.
 class CommandRegistry {
-    std::unordered_map<std::string, CommandFactory> m_CommandFactories;
+    struct Entry {
+        std::string_view name;              // Owned by the command
+        std::unique_ptr<Command> command;
+    };
+
+    std::vector<Entry> m_Commands;          // Sorted by name
 
 public:
-    auto begin() const { return m_CommandFactories.begin(); }
-    auto end() const { return m_CommandFactories.end(); }
-    auto find(const std::string &commandName) const { return m_CommandFactories.find(commandName); }
-    [[nodiscard]] bool contains(const std::string &commandName) const { return m_CommandFactories.contains(commandName); }
-    [[nodiscard]] bool empty() const { return m_CommandFactories.empty(); }
-    [[nodiscard]] size_t size() const { return m_CommandFactories.size(); }
-
-    void registerCommand(const std::string &name, const CommandFactory &factory);
-    Command *createCommand(const std::string &name);
-};
\ No newline at end of file
+    CommandRegistry();
+    ~CommandRegistry();
+
+    auto begin() const { return m_Commands.begin(); }
+    auto end() const { return m_Commands.end(); }
+    [[nodiscard]] bool contains(std::string_view name) const { return find(name) != nullptr; }
+    [[nodiscard]] bool empty() const { return m_Commands.empty(); }
+    [[nodiscard]] size_t size() const { return m_Commands.size(); }
+
+    // Adds a command; returns false if one with the same name exists
+    bool registerCommand(std::unique_ptr<Command> command);
+
+    // Returns the command with the given name, or nullptr
+    [[nodiscard]] Command *find(std::string_view name) const;
+};
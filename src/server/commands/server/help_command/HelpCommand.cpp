@@ -3,19 +3,25 @@
 //
 
 #include "HelpCommand.h"
-#include "server/Server.h"
+#include "server/CommandManager.h"
+#include "server/ModuleManager.h"
+#include "server/modules/NetworkEngine.h"
 
-void HelpCommand::execute(const std::string &args)
+void HelpCommand::execute(Connection sender, std::string_view)
 {
+    auto *commandManager = ModuleManager::instance().findModule<CommandManager>();
+    if (!commandManager) return;
 
+    std::string reply = "Commands:";
+    for (const auto &entry : commandManager->registry())
+    {
+        reply += "\n  /";
+        reply += entry.command->usage();
+    }
+    NetworkEngine::sendData(sender, reply);
 }
 
-std::string HelpCommand::usage() const
+std::string_view HelpCommand::usage() const
 {
-    return "help - Displays a list of commands (this is all it does for now)";
+    return "help - Displays a list of commands";
 }
-
-extern "C" Command *importCommand()
-{
-    return new HelpCommand();
-}
\ No newline at end of file
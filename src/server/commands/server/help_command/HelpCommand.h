@@ -8,7 +8,7 @@
 class HelpCommand : public Command {
 public:
     ~HelpCommand() override = default;
-    void execute(const std::string &args) override;
-    [[nodiscard]] constexpr std::string name() const override { return "help"; }
-    [[nodiscard]] std::string usage() const override;
-};
\ No newline at end of file
+    void execute(Connection sender, std::string_view args) override;
+    [[nodiscard]] std::string_view name() const override { return "help"; }
+    [[nodiscard]] std::string_view usage() const override;
+};
@@ -4,18 +4,25 @@
 
 #include "StopCommand.h"
 #include "server/Server.h"
+#include "server/modules/NetworkEngine.h"
+#include "server/modules/Logger.h"
 
-void StopCommand::execute(const std::string &args)
+void StopCommand::execute(Connection sender, std::string_view)
 {
+    // There are no accounts yet, so only clients on this machine may stop the server
+    std::string ip = NetworkEngine::getIP(sender);
+    if (ip != "127.0.0.1" && ip != "::1" && ip != "::ffff:127.0.0.1")
+    {
+        LOG_WARNING("StopCommand", "Refused /stop from {}", ip);
+        NetworkEngine::sendData(sender, "Permission denied: /stop is only accepted from localhost");
+        return;
+    }
 
+    NetworkEngine::sendData(sender, "Stopping the server");
+    Server::instance().stop();
 }
 
-std::string StopCommand::usage() const
+std::string_view StopCommand::usage() const
 {
     return "stop - Stops the server";
 }
-
-extern "C" Command *importCommand()
-{
-    return new StopCommand();
-}
\ No newline at end of file
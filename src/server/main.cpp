@@ -2,6 +2,5 @@
 
 int main(int argc, char **argv)
 {
-    Server server;
-    return server.run(argc, argv);
+    return Server::instance().run(argc, argv);
 }
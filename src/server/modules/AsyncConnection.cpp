@@ -0,0 +1,231 @@
+//
+// Created by msullivan on 12/16/24.
+//
+
+#include "AsyncConnection.h"
+#include "NetworkEngine.h"
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+// State shared by an AsyncConnection, its pending awaitables and NetworkEngine's threads
+struct AsyncChannel {
+    Executor *executor = nullptr;
+    std::mutex mutex;
+    std::deque<std::string> inbox;
+    std::coroutine_handle<> reader;     // Coroutine waiting in read()
+    uint64_t readSequence = 0;          // Tells a read's timeout whether that read is still waiting
+    std::coroutine_handle<> writer;     // Coroutine waiting in write() for backpressure to clear
+    bool throttled = false;
+    bool closed = false;
+};
+
+// Forward declaration(s)
+void connectChannelSignals();
+std::shared_ptr<AsyncChannel> findChannel(Connection connection);
+
+// Global variables
+std::mutex g_ChannelsMutex;
+std::unordered_map<Connection, std::shared_ptr<AsyncChannel>> g_Channels;
+std::atomic<size_t> g_ChannelCount = 0;     // Lets deliverAsyncFrame() skip the lock when nothing is claimed
+std::once_flag g_ChannelSignalsConnected;
+
+AsyncConnection::AsyncConnection(Connection connection, Executor &executor) : m_Connection(connection), m_Executor(&executor)
+{
+    std::call_once(g_ChannelSignalsConnected, connectChannelSignals);
+
+    auto channel = std::make_shared<AsyncChannel>();
+    channel->executor = &executor;
+    {
+        std::lock_guard lock(g_ChannelsMutex);
+        if (!g_Channels.try_emplace(connection, channel).second) return;
+        g_ChannelCount.fetch_add(1);
+    }
+    m_Channel = std::move(channel);
+
+    // Checked after the claim: disconnect() marks the connection before it emits clientDisconnected, which
+    // closes claimed channels, so a disconnect either sees this claim or is seen here
+    if (!NetworkEngine::isValidConnection(connection))
+    {
+        std::lock_guard lock(m_Channel->mutex);
+        m_Channel->closed = true;
+    }
+}
+
+AsyncConnection::AsyncConnection(AsyncConnection &&other) noexcept :
+    m_Connection(other.m_Connection), m_Executor(other.m_Executor), m_Channel(std::move(other.m_Channel))
+{}
+
+AsyncConnection::~AsyncConnection()
+{
+    if (!m_Channel) return;
+    {
+        std::lock_guard lock(g_ChannelsMutex);
+        auto it = g_Channels.find(m_Connection);
+        if (it != g_Channels.end() && it->second == m_Channel)
+        {
+            g_Channels.erase(it);
+            g_ChannelCount.fetch_sub(1);
+        }
+    }
+
+    // Frames nobody read go to the usual slots
+    std::deque<std::string> unread;
+    {
+        std::lock_guard lock(m_Channel->mutex);
+        if (m_Channel->closed) return;
+        unread.swap(m_Channel->inbox);
+    }
+    for (const auto &frame : unread)
+        NetworkEngine::receivedData(Connection(m_Connection), frame);
+}
+
+AsyncConnection::ReadAwaitable AsyncConnection::read(std::chrono::milliseconds timeout)
+{
+    return {m_Channel, m_Executor, m_Connection, timeout};
+}
+
+AsyncConnection::WriteAwaitable AsyncConnection::write(const std::string &data)
+{
+    return {m_Channel, m_Connection, m_Channel && NetworkEngine::sendData(m_Connection, data)};
+}
+
+bool AsyncConnection::ReadAwaitable::await_ready() const
+{
+    if (!channel) return true;
+    std::lock_guard lock(channel->mutex);
+    return !channel->inbox.empty() || channel->closed;
+}
+
+bool AsyncConnection::ReadAwaitable::await_suspend(std::coroutine_handle<> handle)
+{
+    // Once the reader is published the coroutine may resume elsewhere and free this awaitable, so nothing
+    // of it is read after the lock is released
+    auto target = channel;
+    Executor *timerExecutor = executor;
+    auto readTimeout = timeout;
+    auto strand = static_cast<uint64_t>(connection);
+    uint64_t sequence;
+    {
+        std::lock_guard lock(target->mutex);
+        if (!target->inbox.empty() || target->closed) return false;
+        target->reader = handle;
+        sequence = ++target->readSequence;
+    }
+    if (readTimeout == std::chrono::milliseconds::zero()) return true;
+
+    timerExecutor->postAt(Executor::Clock::now() + readTimeout, [target, sequence]
+    {
+        std::coroutine_handle<> reader;
+        {
+            std::lock_guard lock(target->mutex);
+            if (target->readSequence != sequence) return;
+            reader = std::exchange(target->reader, nullptr);
+        }
+        if (reader) reader.resume();
+    }, strand);
+    return true;
+}
+
+std::optional<std::string> AsyncConnection::ReadAwaitable::await_resume()
+{
+    if (!channel) return std::nullopt;
+    std::lock_guard lock(channel->mutex);
+    if (channel->inbox.empty()) return std::nullopt;
+
+    std::string frame = std::move(channel->inbox.front());
+    channel->inbox.pop_front();
+    return frame;
+}
+
+bool AsyncConnection::WriteAwaitable::await_ready() const
+{
+    if (!sent) return true;
+    std::lock_guard lock(channel->mutex);
+    return channel->closed || !channel->throttled;
+}
+
+bool AsyncConnection::WriteAwaitable::await_suspend(std::coroutine_handle<> handle)
+{
+    std::lock_guard lock(channel->mutex);
+    if (channel->closed || !channel->throttled) return false;
+    channel->writer = handle;
+    return true;
+}
+
+bool AsyncConnection::WriteAwaitable::await_resume() const
+{
+    if (!sent) return false;
+    std::lock_guard lock(channel->mutex);
+    return !channel->closed;
+}
+
+bool deliverAsyncFrame(Connection connection, const std::string &frame)
+{
+    if (g_ChannelCount.load(std::memory_order_relaxed) == 0) return false;
+    if (frame == "KEEPALIVE") return false;
+
+    auto channel = findChannel(connection);
+    if (!channel) return false;
+
+    std::coroutine_handle<> reader;
+    {
+        std::lock_guard lock(channel->mutex);
+        channel->inbox.emplace_back(frame);
+        reader = std::exchange(channel->reader, nullptr);
+    }
+    if (reader) channel->executor->post(static_cast<uint64_t>(connection), [reader] { reader.resume(); });
+    return true;
+}
+
+std::shared_ptr<AsyncChannel> findChannel(Connection connection)
+{
+    std::lock_guard lock(g_ChannelsMutex);
+    auto it = g_Channels.find(connection);
+    return it != g_Channels.end() ? it->second : nullptr;
+}
+
+// Wakes waiting coroutines when their client leaves or its send queue drains
+void connectChannelSignals()
+{
+    NetworkEngine::clientDisconnected.connect([](Connection connection)
+    {
+        if (g_ChannelCount.load() == 0) return;
+
+        std::shared_ptr<AsyncChannel> channel;
+        {
+            std::lock_guard lock(g_ChannelsMutex);
+            auto it = g_Channels.find(connection);
+            if (it == g_Channels.end()) return;
+            channel = std::move(it->second);
+            g_Channels.erase(it);
+            g_ChannelCount.fetch_sub(1);
+        }
+
+        std::coroutine_handle<> reader, writer;
+        {
+            std::lock_guard lock(channel->mutex);
+            channel->closed = true;
+            channel->readSequence++;
+            reader = std::exchange(channel->reader, nullptr);
+            writer = std::exchange(channel->writer, nullptr);
+        }
+        if (reader) channel->executor->post(static_cast<uint64_t>(connection), [reader] { reader.resume(); });
+        if (writer) channel->executor->post(static_cast<uint64_t>(connection), [writer] { writer.resume(); });
+    });
+
+    NetworkEngine::backpressure.connect([](Connection connection, bool throttled)
+    {
+        if (g_ChannelCount.load() == 0) return;
+        auto channel = findChannel(connection);
+        if (!channel) return;
+
+        std::coroutine_handle<> writer;
+        {
+            std::lock_guard lock(channel->mutex);
+            channel->throttled = throttled;
+            if (!throttled) writer = std::exchange(channel->writer, nullptr);
+        }
+        if (writer) channel->executor->post(static_cast<uint64_t>(connection), [writer] { writer.resume(); });
+    });
+}
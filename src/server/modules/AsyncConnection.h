@@ -0,0 +1,74 @@
+//
+// Created by msullivan on 12/16/24.
+//
+
+#pragma once
+#include "ServerModule.h"
+#include "server/Task.h"
+#include <chrono>
+#include <coroutine>
+#include <memory>
+#include <optional>
+#include <string>
+
+struct AsyncChannel;
+
+// Awaitable access to one client for coroutines (see server/Task.h). While an AsyncConnection holds a client,
+// its frames are queued for read() instead of being emitted on NetworkEngine::receivedData; frames still
+// unread when it is released are emitted then. Coroutines resume on the executor, in the client's strand.
+// A client can be held by one AsyncConnection at a time, and each one serves a single coroutine.
+class AsyncConnection {
+    Connection m_Connection;
+    Executor *m_Executor;
+    std::shared_ptr<AsyncChannel> m_Channel;    // Null if the client could not be claimed
+
+public:
+    struct ReadAwaitable {
+        std::shared_ptr<AsyncChannel> channel;
+        Executor *executor;
+        Connection connection;
+        std::chrono::milliseconds timeout;
+
+        bool await_ready() const;
+        bool await_suspend(std::coroutine_handle<> handle);
+        std::optional<std::string> await_resume();
+    };
+
+    struct WriteAwaitable {
+        std::shared_ptr<AsyncChannel> channel;
+        Connection connection;
+        bool sent;
+
+        bool await_ready() const;
+        bool await_suspend(std::coroutine_handle<> handle);
+        bool await_resume() const;
+    };
+
+    AsyncConnection(Connection connection, Executor &executor);
+    ~AsyncConnection();
+
+    AsyncConnection(AsyncConnection &&other) noexcept;
+    AsyncConnection &operator=(AsyncConnection &&) = delete;
+    AsyncConnection(const AsyncConnection &) = delete;
+    AsyncConnection &operator=(const AsyncConnection &) = delete;
+
+    // False if the client was gone or already held by another AsyncConnection
+    explicit operator bool() const { return m_Channel != nullptr; }
+    [[nodiscard]] Connection connection() const { return m_Connection; }
+
+    // Waits for the next frame; nullopt once the client disconnects or after timeout (0 waits forever)
+    ReadAwaitable read(std::chrono::milliseconds timeout = std::chrono::milliseconds::zero());
+
+    // Queues a frame, then waits while the client is over its send high watermark; false if it disconnected
+    WriteAwaitable write(const std::string &data);
+
+    // Waits for a while, resuming in this client's strand
+    [[nodiscard]] SleepAwaitable sleep(Executor::Clock::duration duration) const
+    {
+        return sleepFor(*m_Executor, duration, static_cast<uint64_t>(m_Connection));
+    }
+};
+
+// Offers a received frame to the AsyncConnection holding its client; returns false if there is none.
+// Called by NetworkEngine before it emits receivedData.
+bool deliverAsyncFrame(Connection connection, const std::string &frame);
@@ -0,0 +1,183 @@
+//
+// Created by msullivan on 12/11/24.
+//
+
+#include "BinaryLogSink.h"
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+constexpr size_t MIN_BINARY_LOG_FILE_SIZE = 64 * 1024;
+
+BinaryLogSink::~BinaryLogSink()
+{
+    close();
+}
+
+bool BinaryLogSink::open(const std::string &path, size_t fileSize, size_t maxFiles)
+{
+    close();
+    m_Path = path;
+    m_FileSize = std::max(fileSize, MIN_BINARY_LOG_FILE_SIZE);
+    m_MaxFiles = std::max<size_t>(maxFiles, 1);
+
+    // Continue after the newest file a previous run left behind
+    std::filesystem::path base(path);
+    std::filesystem::path directory = base.has_parent_path() ? base.parent_path() : ".";
+    std::string prefix = base.filename().string() + '.';
+    std::vector<uint64_t> existing;
+    m_Sequence = 0;
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(directory, error))
+    {
+        std::string name = entry.path().filename().string();
+        if (!name.starts_with(prefix) || name.size() == prefix.size()) continue;
+
+        std::string_view suffix = std::string_view(name).substr(prefix.size());
+        uint64_t sequence;
+        auto [end, result] = std::from_chars(suffix.data(), suffix.data() + suffix.size(), sequence);
+        if (result != std::errc() || end != suffix.data() + suffix.size() || sequence == UINT64_MAX) continue;
+        existing.push_back(sequence);
+        m_Sequence = std::max<uint64_t>(m_Sequence, sequence + 1);
+    }
+
+    // Everything outside the retention window, counting the file about to be created; rotation then keeps it that way
+    for (uint64_t sequence : existing)
+        if (sequence + m_MaxFiles <= m_Sequence)
+            std::filesystem::remove(m_Path + '.' + std::to_string(sequence), error);
+
+    return openFile();
+}
+
+void BinaryLogSink::close()
+{
+    closeFile();
+}
+
+void BinaryLogSink::defineModule(uint16_t module, std::string_view name)
+{
+    define(BinaryLogEntry::Module, 0, module, name, {});
+}
+
+void BinaryLogSink::defineFormat(uint32_t format, uint16_t module, uint8_t level, std::string_view text)
+{
+    define(BinaryLogEntry::Format, level, module, std::string_view(reinterpret_cast<const char *>(&format), sizeof(format)), text);
+}
+
+void BinaryLogSink::writeRecord(std::chrono::system_clock::time_point time, uint8_t level, uint16_t module,
+                                uint32_t format, std::string_view arguments)
+{
+    size_t size = sizeof(BinaryLogEntryHeader) + BINARY_LOG_RECORD_PREFIX + arguments.size();
+    char *out = reserve(size);
+    if (!out) return;
+
+    BinaryLogEntryHeader header {static_cast<uint32_t>(size), BinaryLogEntry::Record, level, module};
+    auto nanoseconds = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count());
+
+    std::memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+    std::memcpy(out, &nanoseconds, sizeof(nanoseconds));
+    std::memcpy(out + sizeof(nanoseconds), &format, sizeof(format));
+    std::memcpy(out + BINARY_LOG_RECORD_PREFIX, arguments.data(), arguments.size());
+    m_Used += size;
+}
+
+// Records a definition for replay and writes it to the current file
+void BinaryLogSink::define(BinaryLogEntry type, uint8_t level, uint16_t module, std::string_view first,
+                           std::string_view second)
+{
+    size_t size = sizeof(BinaryLogEntryHeader) + first.size() + second.size();
+    BinaryLogEntryHeader header {static_cast<uint32_t>(size), type, level, module};
+    size_t offset = m_Definitions.size();
+    m_Definitions.append(reinterpret_cast<const char *>(&header), sizeof(header));
+    m_Definitions.append(first);
+    m_Definitions.append(second);
+
+    // A rotation inside reserve() already replayed it
+    uint64_t sequence = m_Sequence;
+    char *out = reserve(size);
+    if (!out || sequence != m_Sequence) return;
+
+    std::memcpy(out, m_Definitions.data() + offset, size);
+    m_Used += size;
+}
+
+// Returns where an entry of the given size goes, rotating first if the current file is full
+char *BinaryLogSink::reserve(size_t size)
+{
+    if (!m_Data) return nullptr;
+    if (m_Used + size > m_FileSize)
+    {
+        closeFile();
+        m_Sequence++;
+        if (!openFile() || m_Used + size > m_FileSize) return nullptr;
+    }
+    return m_Data + m_Used;
+}
+
+bool BinaryLogSink::openFile()
+{
+    // Every file starts with all definitions so far; grow the files rather than lose some, keeping at least
+    // half of each for records
+    while (sizeof(BinaryLogFileHeader) + m_Definitions.size() > m_FileSize / 2)
+        m_FileSize *= 2;
+
+    std::string name = m_Path + '.' + std::to_string(m_Sequence);
+    m_FD = ::open(name.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (m_FD == -1) return false;
+
+    if (ftruncate(m_FD, static_cast<off_t>(m_FileSize)) == -1)
+    {
+        ::close(m_FD);
+        m_FD = -1;
+        return false;
+    }
+
+    void *data = mmap(nullptr, m_FileSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_FD, 0);
+    if (data == MAP_FAILED)
+    {
+        ::close(m_FD);
+        m_FD = -1;
+        return false;
+    }
+    m_Data = static_cast<char *>(data);
+
+    BinaryLogFileHeader header {};
+    std::memcpy(header.magic, BINARY_LOG_MAGIC, sizeof(header.magic));
+    header.version = BINARY_LOG_VERSION;
+    header.byteOrder = BINARY_LOG_BYTE_ORDER;
+    std::memcpy(m_Data, &header, sizeof(header));
+    std::memcpy(m_Data + sizeof(header), m_Definitions.data(), m_Definitions.size());
+    m_Used = sizeof(header) + m_Definitions.size();
+
+    // Drop the oldest file beyond the limit
+    if (m_Sequence >= m_MaxFiles)
+    {
+        std::error_code error;
+        std::filesystem::remove(m_Path + '.' + std::to_string(m_Sequence - m_MaxFiles), error);
+    }
+    return true;
+}
+
+// Unmaps the current file and trims it to the entries written
+void BinaryLogSink::closeFile()
+{
+    if (m_Data)
+    {
+        munmap(m_Data, m_FileSize);
+        m_Data = nullptr;
+    }
+    if (m_FD != -1)
+    {
+        // If trimming fails the file keeps its zero-filled tail, which readers treat as the end
+        [[maybe_unused]] int trimmed = ftruncate(m_FD, static_cast<off_t>(m_Used));
+        ::close(m_FD);
+        m_FD = -1;
+    }
+    m_Used = 0;
+}
@@ -0,0 +1,55 @@
+//
+// Created by msullivan on 12/11/24.
+//
+
+#pragma once
+#include "common/BinaryLog.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Writes binary log entries (see common/BinaryLog.h) into memory-mapped files named <path>.<sequence>.
+// A file is sized up front; when the next entry does not fit, it is trimmed to what was written and
+// the next one is started with the definitions replayed. Files grow past fileSize if the definitions would
+// take more than half of one. Only the newest maxFiles files are kept.
+// Not thread-safe; Logger only uses it from its consumer.
+class BinaryLogSink {
+    std::string m_Path;
+    size_t m_FileSize = 0;      // Of the current file
+    size_t m_MaxFiles = 0;
+    uint64_t m_Sequence = 0;    // Of the current file
+
+    int m_FD = -1;
+    char *m_Data = nullptr;
+    size_t m_Used = 0;
+
+    std::string m_Definitions;  // Every Module and Format entry so far, replayed at the start of each file
+
+    bool openFile();
+    void closeFile();
+    char *reserve(size_t size);
+    void define(BinaryLogEntry type, uint8_t level, uint16_t module, std::string_view first, std::string_view second);
+
+public:
+    BinaryLogSink() = default;
+    ~BinaryLogSink();
+    BinaryLogSink(const BinaryLogSink &) = delete;
+    BinaryLogSink &operator=(const BinaryLogSink &) = delete;
+
+    // Starts a new file after the newest existing one for path; returns false if it could not be created
+    bool open(const std::string &path, size_t fileSize, size_t maxFiles);
+
+    // Trims and closes the current file
+    void close();
+
+    [[nodiscard]] bool isOpen() const { return m_Data != nullptr; }
+
+    void defineModule(uint16_t module, std::string_view name);
+    void defineFormat(uint32_t format, uint16_t module, uint8_t level, std::string_view text);
+
+    // Writes a record; arguments holds the encoded arguments
+    void writeRecord(std::chrono::system_clock::time_point time, uint8_t level, uint16_t module, uint32_t format,
+                     std::string_view arguments);
+};
@@ -0,0 +1,57 @@
+//
+// Created by msullivan on 12/3/24.
+//
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Dense descriptor -> (owner, entity) table behind NetworkEngine's connection lookups. It is sized once, so
+// lookups never race a reallocation and cost one bounds check and one array index regardless of load.
+//
+// An entry's owner is published last and cleared first, so a reader that finds an owner, locks it and sees the
+// same owner again can trust the entity until it releases the lock.
+template<typename Owner, typename Entity, Entity Null>
+class FDIndex {
+    struct Entry {
+        std::atomic<Owner *> owner {nullptr};
+        std::atomic<Entity> entity {Null};
+    };
+
+    std::unique_ptr<Entry[]> m_Entries;
+    size_t m_Size = 0;
+
+public:
+    // Replaces the table with an empty one of the given capacity; not safe while lookups are running
+    void reset(size_t capacity)
+    {
+        m_Entries = capacity ? std::make_unique<Entry[]>(capacity) : nullptr;
+        m_Size = capacity;
+    }
+
+    [[nodiscard]] size_t size() const { return m_Size; }
+    [[nodiscard]] bool contains(int fd) const { return fd >= 0 && static_cast<size_t>(fd) < m_Size; }
+
+    // The caller must hold the owner's lock and have checked contains(fd)
+    void publish(int fd, Owner *owner, Entity entity)
+    {
+        m_Entries[fd].entity.store(entity, std::memory_order_relaxed);
+        m_Entries[fd].owner.store(owner, std::memory_order_release);
+    }
+
+    void clear(int fd)
+    {
+        m_Entries[fd].owner.store(nullptr, std::memory_order_release);
+        m_Entries[fd].entity.store(Null, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] Owner *owner(int fd) const
+    {
+        if (!contains(fd)) [[unlikely]] return nullptr;
+        return m_Entries[fd].owner.load(std::memory_order_acquire);
+    }
+
+    // Only meaningful after owner(fd) returned an owner whose lock is held
+    [[nodiscard]] Entity entity(int fd) const { return m_Entries[fd].entity.load(std::memory_order_relaxed); }
+};
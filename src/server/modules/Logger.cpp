@@ -3,55 +3,494 @@
 //
 
 #include "Logger.h"
-#include <iomanip>
+#include "BinaryLogSink.h"
+#include "common/Timestamp.h"
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <ctime>
+#include <unordered_map>
+
+/* Records */
+constexpr size_t LOG_RECORD_SIZE = 256;
+
+// One slot of a log ring. A message longer than one record continues in the records after it.
+struct LogRecord {
+    static constexpr size_t TEXT_SIZE = LOG_RECORD_SIZE - 16;
+
+    std::chrono::system_clock::time_point time;
+    LogLevel level;
+    bool continued;         // The message goes on in the next record
+    bool binary;            // Format id, module id and encoded arguments rather than text
+    uint16_t length;
+    char text[TEXT_SIZE];
+};
+static_assert(sizeof(LogRecord) == LOG_RECORD_SIZE);
+
+// Single-producer/single-consumer ring. The producer is the thread that owns it; the consumer is whoever
+// holds g_ConsumerMutex (normally the writer thread).
+class LogRing {
+    std::unique_ptr<LogRecord[]> m_Records;
+    size_t m_Capacity;
+    alignas(64) std::atomic<size_t> m_Head {0};     // Next record to read; advanced by the consumer
+    alignas(64) std::atomic<size_t> m_Tail {0};     // Next record to write; advanced by the producer
+    size_t m_CachedHead = 0;                        // Producer's last look at m_Head
+
+public:
+    alignas(64) std::atomic<size_t> dropped {0};    // Messages discarded under LogOverflow::Drop
+    std::atomic<bool> abandoned {false};            // The owning thread has exited
+
+    explicit LogRing(size_t capacity)
+            : m_Records(std::make_unique_for_overwrite<LogRecord[]>(capacity)), m_Capacity(capacity)
+    {}
+
+    // Longest message that is accepted whole; anything longer is truncated so one message never fills the ring
+    [[nodiscard]] size_t maxMessageSize() const { return m_Capacity / 2 * LogRecord::TEXT_SIZE; }
+
+    // Producer: copies a message into as many records as it needs; returns false if they don't fit
+    bool push(LogLevel level, std::chrono::system_clock::time_point time, std::string_view message, bool binary)
+    {
+        size_t needed = std::max<size_t>(1, (message.size() + LogRecord::TEXT_SIZE - 1) / LogRecord::TEXT_SIZE);
+        size_t tail = m_Tail.load(std::memory_order_relaxed);
+        if (tail + needed - m_CachedHead > m_Capacity)
+        {
+            m_CachedHead = m_Head.load(std::memory_order_acquire);
+            if (tail + needed - m_CachedHead > m_Capacity) return false;
+        }
+
+        for (size_t i = 0; i < needed; i++)
+        {
+            auto &record = m_Records[(tail + i) & (m_Capacity - 1)];
+            size_t offset = i * LogRecord::TEXT_SIZE;
+            size_t length = std::min(LogRecord::TEXT_SIZE, message.size() - offset);
+
+            record.time = time;
+            record.level = level;
+            record.continued = i + 1 < needed;
+            record.binary = binary;
+            record.length = static_cast<uint16_t>(length);
+            std::memcpy(record.text, message.data() + offset, length);
+        }
+
+        // Publish the whole message at once
+        m_Tail.store(tail + needed, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: hands every published record to visit and releases them; returns the number of records
+    template<typename Visitor>
+    size_t drain(Visitor &&visit)
+    {
+        size_t head = m_Head.load(std::memory_order_relaxed);
+        size_t tail = m_Tail.load(std::memory_order_acquire);
+        for (size_t i = head; i != tail; i++)
+            visit(m_Records[i & (m_Capacity - 1)]);
+
+        m_Head.store(tail, std::memory_order_release);
+        return tail - head;
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return m_Head.load(std::memory_order_acquire) == m_Tail.load(std::memory_order_acquire);
+    }
+};
+
+// Gives a thread's ring back to the writer when the thread exits
+struct ThreadRing {
+    std::shared_ptr<LogRing> ring;
+    ~ThreadRing() { if (ring) ring->abandoned.store(true, std::memory_order_release); }
+};
+
+// Global variables
+LoggerConfig g_LoggerConfig;
+thread_local ThreadRing t_Ring;
+
+std::atomic<LogLevel> g_LogFloor = LogLevel::Info;
+std::atomic<uint32_t> g_LogGeneration = 1;          // Sites start at 0, so each resolves on first use
+std::atomic<LogLevel> g_LogLevel = LogLevel::Info;  // Level of modules without an override
+std::mutex g_LevelsMutex;                           // Guards g_ModuleLevels and the site tables; serializes level changes
+std::unordered_map<std::string, LogLevel> g_ModuleLevels;
+
+// Binary sink
+std::atomic<bool> g_LogBinary = false;
+BinaryLogSink g_BinarySink;                         // Used by the consumer
+constinit LogSite g_PlainSite {"", "{}", LogLevel::Info};   // Carries Logger::log() messages as one string argument
+std::vector<const LogSite *> g_Sites;               // Indexed by format id - 1
+std::vector<std::string> g_ModuleNames {""};        // Indexed by module id
+std::unordered_map<std::string, uint16_t> g_ModuleIDs {{"", 0}};
+uint32_t g_DefinedSites = 0;                        // Definitions handed to the sink so far; consumer only
+uint16_t g_DefinedModules = 0;
+
+std::mutex g_RingsMutex;                            // Guards g_Rings; producers only take it once per thread
+std::vector<std::shared_ptr<LogRing>> g_Rings;
+
+std::mutex g_ConsumerMutex;                         // Held by whoever drains the rings or writes to the sink
+std::vector<std::shared_ptr<LogRing>> g_DrainList;  // Scratch copy of g_Rings for the consumer
+std::string g_Output;                               // Batch buffer for the consumer
+std::string g_Message;                              // Reassembles messages that span records
+TimestampCache g_Timestamps;                        // Line timestamps; used by the consumer
+
+std::thread g_Writer;
+std::atomic<bool> g_WriterRunning = false;
+std::atomic<bool> g_WriterSleeping = false;
+std::mutex g_WakeupMutex;
+std::condition_variable g_Wakeup;
+
+constexpr auto WRITER_IDLE_WAIT = std::chrono::milliseconds(50);   // Also bounds the delay of a missed wakeup
 
 // Forward declaration(s)
-std::string getCurrentTimestamp();
 std::string logLevelToString(LogLevel);
+const char *logLevelToColor(LogLevel);
+void appendLine(std::string &output, LogLevel level, std::chrono::system_clock::time_point time, std::string_view message);
+void writeOutput(std::string &output);
+LogRing &threadRing();
+size_t drainRings();
+bool hasPendingRecords();
+void wakeWriter();
+void runWriter();
+void updateLevels();
+void registerSite(const LogSite &site);
+void emitText(LogLevel level, std::chrono::system_clock::time_point time, std::string_view message);
+void emitBinary(LogLevel level, std::chrono::system_clock::time_point time, std::string_view message);
+void encodePlain(std::string &out, std::string_view message);
+
+Logger::Logger(LoggerConfig config) : m_Config(config)
+{}
+
+Logger::~Logger()
+{
+    if (g_Writer.joinable())
+    {
+        g_WriterRunning.store(false, std::memory_order_release);
+        g_Wakeup.notify_one();
+        g_Writer.join();
+    }
+
+    // Whatever was queued after the writer's last pass
+    drainRings();
+
+    std::lock_guard lock(g_ConsumerMutex);
+    g_LogBinary.store(false, std::memory_order_release);
+    g_BinarySink.close();
+}
+
+void Logger::init()
+{
+    g_LoggerConfig = m_Config;
+    g_LoggerConfig.ringCapacity = std::bit_ceil(std::max<size_t>(g_LoggerConfig.ringCapacity, 2));
 
-Logger::~Logger() = default;
+    {
+        std::lock_guard lock(g_LevelsMutex);
+        g_LogLevel.store(m_Config.level, std::memory_order_relaxed);
+        for (const auto &[module, level] : m_Config.moduleLevels)
+            g_ModuleLevels[module] = level;
+        updateLevels();
+        registerSite(g_PlainSite);
+    }
+
+    if (m_Config.sink == LogSink::Binary)
+    {
+        std::lock_guard lock(g_ConsumerMutex);
+        if (g_BinarySink.open(m_Config.binaryPath, m_Config.binaryFileSize, m_Config.binaryFileCount))
+            g_LogBinary.store(true, std::memory_order_release);
+    }
+    if (m_Config.sink == LogSink::Binary && !g_LogBinary.load(std::memory_order_relaxed))
+        log(LogLevel::Error, "Failed to create binary log " + m_Config.binaryPath + "; logging text instead");
+    m_Initialized = true;
+}
 
-void Logger::init() {}
-void Logger::run() {}
+void Logger::run()
+{
+    g_WriterRunning.store(true, std::memory_order_release);
+    g_Writer = std::thread(runWriter);
+    m_Active = true;
+}
 
 void Logger::log(LogLevel level, const std::string &message)
 {
-    std::string timestamp = getCurrentTimestamp();
-    std::string levelStr = logLevelToString(level);
+    if (level < g_LogLevel.load(std::memory_order_relaxed)) return;
+    if (g_LogBinary.load(std::memory_order_acquire))
+    {
+        thread_local std::string encoded;
+        encoded.clear();
+        encodePlain(encoded, message);
+        write(level, encoded, true);
+    }
+    else
+        write(level, message, false);
+}
+
+void Logger::write(LogLevel level, std::string_view message, bool binary)
+{
+    auto time = std::chrono::system_clock::now();
+
+    // Until the writer thread runs (and once it stopped) messages are written by the caller
+    if (!g_WriterRunning.load(std::memory_order_acquire))
+    {
+        std::lock_guard lock(g_ConsumerMutex);
+        if (binary)
+            emitBinary(level, time, message);
+        else
+            emitText(level, time, message);
+        writeOutput(g_Output);
+        return;
+    }
+
+    // Text is truncated to fit the ring; a cut binary record could not be decoded, so it is dropped
+    LogRing &ring = threadRing();
+    if (binary && message.size() > ring.maxMessageSize())
+    {
+        ring.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    std::string_view text = message.substr(0, ring.maxMessageSize());
+    while (!ring.push(level, time, text, binary))
+    {
+        if (g_LoggerConfig.overflow == LogOverflow::Drop)
+        {
+            ring.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // LogOverflow::Block: let the writer catch up, or drain ourselves if it is gone
+        if (g_WriterRunning.load(std::memory_order_acquire))
+            wakeWriter();
+        else
+            drainRings();
+        std::this_thread::yield();
+    }
+    wakeWriter();
+
+    // The writer may have stopped between the check above and the push; don't strand the message.
+    // Fatal messages usually precede exit(), so they are written before returning.
+    if (level == LogLevel::Fatal || !g_WriterRunning.load(std::memory_order_acquire))
+        flush();
+}
+
+void Logger::flush()
+{
+    // Draining is serialized with the writer thread, so any thread may do it
+    drainRings();
+}
+
+void Logger::setLevel(LogLevel level)
+{
+    std::lock_guard lock(g_LevelsMutex);
+    g_LogLevel.store(level, std::memory_order_relaxed);
+    updateLevels();
+}
+
+void Logger::setModuleLevel(const std::string &module, LogLevel level)
+{
+    std::lock_guard lock(g_LevelsMutex);
+    g_ModuleLevels[module] = level;
+    updateLevels();
+}
+
+void Logger::clearModuleLevel(const std::string &module)
+{
+    std::lock_guard lock(g_LevelsMutex);
+    g_ModuleLevels.erase(module);
+    updateLevels();
+}
+
+// Caches whether a call site is enabled under the current level configuration
+void Logger::resolve(const LogSite &site, uint32_t generation)
+{
+    std::lock_guard lock(g_LevelsMutex);
+    registerSite(site);
+    LogLevel threshold = g_LogLevel.load(std::memory_order_relaxed);
+    if (auto it = g_ModuleLevels.find(site.module); it != g_ModuleLevels.end())
+        threshold = it->second;
+
+    // A change racing with this stores a newer generation, which makes the site resolve again
+    site.enabled.store(site.level >= threshold, std::memory_order_relaxed);
+    site.generation.store(generation, std::memory_order_release);
+}
+
+// Gives a site its format id and module id on first use. The caller holds g_LevelsMutex.
+void registerSite(const LogSite &site)
+{
+    if (site.id != 0) return;
+
+    auto [it, inserted] = g_ModuleIDs.try_emplace(site.module, static_cast<uint16_t>(g_ModuleNames.size()));
+    if (inserted) g_ModuleNames.emplace_back(site.module);
+
+    g_Sites.emplace_back(&site);
+    site.moduleID = it->second;
+    site.id = static_cast<uint32_t>(g_Sites.size());
+}
+
+// Recomputes the floor and invalidates every site's cached answer. The caller holds g_LevelsMutex.
+void updateLevels()
+{
+    LogLevel floor = g_LogLevel.load(std::memory_order_relaxed);
+    for (const auto &[module, level] : g_ModuleLevels)
+        floor = std::min(floor, level);
+
+    g_LogFloor.store(floor, std::memory_order_relaxed);
+    g_LogGeneration.fetch_add(1, std::memory_order_release);
+}
+
+// Returns the calling thread's ring, creating and registering it on first use
+LogRing &threadRing()
+{
+    if (!t_Ring.ring) [[unlikely]]
+    {
+        auto ring = std::make_shared<LogRing>(g_LoggerConfig.ringCapacity);
+        std::lock_guard lock(g_RingsMutex);
+        g_Rings.emplace_back(ring);
+        t_Ring.ring = std::move(ring);
+    }
+    return *t_Ring.ring;
+}
+
+// Writes everything queued on every ring to the sink in one batch; returns the number of records written
+size_t drainRings()
+{
+    std::lock_guard lock(g_ConsumerMutex);
+    {
+        std::lock_guard ringsLock(g_RingsMutex);
+        g_DrainList.assign(g_Rings.begin(), g_Rings.end());
+    }
+
+    size_t records = 0;
+    for (auto &ring : g_DrainList)
+    {
+        if (size_t dropped = ring->dropped.exchange(0, std::memory_order_relaxed))
+            emitText(LogLevel::Warning, std::chrono::system_clock::now(),
+                     std::to_string(dropped) + " log message(s) dropped; the log ring was full");
+
+        records += ring->drain([](const LogRecord &record)
+        {
+            g_Message.append(record.text, record.length);
+            if (record.continued) return;
+
+            if (record.binary)
+                emitBinary(record.level, record.time, g_Message);
+            else
+                emitText(record.level, record.time, g_Message);
+            g_Message.clear();
+        });
+    }
+
+    // Forget the rings of threads that exited once they are empty
+    bool abandoned = std::ranges::any_of(g_DrainList, [](const auto &ring)
+    {
+        return ring->abandoned.load(std::memory_order_acquire) && ring->empty();
+    });
+    if (abandoned)
+    {
+        std::lock_guard ringsLock(g_RingsMutex);
+        std::erase_if(g_Rings, [](const auto &ring)
+        {
+            return ring->abandoned.load(std::memory_order_acquire) && ring->empty();
+        });
+    }
+    g_DrainList.clear();
 
-    std::string colorCode;
-    switch (level) {
-        case LogLevel::Debug:
-            colorCode = "\033[36m"; // Cyan
-        break;
-        case LogLevel::Info:
-            colorCode = "\033[37m"; // White (default)
-        break;
-        case LogLevel::Warning:
-            colorCode = "\033[33m"; // Yellow
-        break;
-        case LogLevel::Error:
-            colorCode = "\033[31m"; // Red
-        break;
-        default:
-            colorCode = "\033[0m";  // Reset to default
-        break;
+    writeOutput(g_Output);
+    return records;
+}
+
+bool hasPendingRecords()
+{
+    std::lock_guard lock(g_RingsMutex);
+    return std::ranges::any_of(g_Rings, [](const auto &ring) { return !ring->empty(); });
+}
+
+// Wakes the writer if it is waiting for work
+void wakeWriter()
+{
+    if (g_WriterSleeping.load(std::memory_order_acquire)) [[unlikely]]
+    {
+        std::lock_guard lock(g_WakeupMutex);
+        g_Wakeup.notify_one();
+    }
+}
+
+// Writer thread; drains the rings in batches and sleeps while they are empty
+void runWriter()
+{
+    while (g_WriterRunning.load(std::memory_order_acquire))
+    {
+        if (drainRings() > 0) continue;
+
+        std::unique_lock lock(g_WakeupMutex);
+        g_WriterSleeping.store(true, std::memory_order_seq_cst);
+        if (g_WriterRunning.load(std::memory_order_acquire) && !hasPendingRecords())
+            g_Wakeup.wait_for(lock, WRITER_IDLE_WAIT);
+        g_WriterSleeping.store(false, std::memory_order_relaxed);
     }
+}
 
-    std::ostringstream logStream;
-    logStream << colorCode << "[" << timestamp << "] [" << levelStr << "] " << message << "\033[0m";
-    std::cout << logStream.str() << std::endl;
+// Hands a text message to the active sink. The caller holds g_ConsumerMutex.
+void emitText(LogLevel level, std::chrono::system_clock::time_point time, std::string_view message)
+{
+    if (g_BinarySink.isOpen())
+    {
+        thread_local std::string encoded;
+        encoded.clear();
+        encodePlain(encoded, message);
+        emitBinary(level, time, encoded);
+    }
+    else
+        appendLine(g_Output, level, time, message);
 }
 
-std::string getCurrentTimestamp()
+// Writes a record queued by a binary producer, preceded by any definitions the sink has not seen.
+// The caller holds g_ConsumerMutex.
+void emitBinary(LogLevel level, std::chrono::system_clock::time_point time, std::string_view message)
 {
-    auto now = std::chrono::system_clock::now();
-    auto timePoint = std::chrono::system_clock::to_time_t(now);
-    std::tm tm = *std::localtime(&timePoint);
+    if (!g_BinarySink.isOpen() || message.size() < sizeof(uint32_t) + sizeof(uint16_t)) return;
+    auto format = readBinaryValue<uint32_t>(message.data());
+    auto module = readBinaryValue<uint16_t>(message.data() + sizeof(uint32_t));
 
-    std::ostringstream timestampStream;
-    timestampStream << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
-    return timestampStream.str();
+    if (format > g_DefinedSites || module >= g_DefinedModules)
+    {
+        std::lock_guard lock(g_LevelsMutex);
+        for (; g_DefinedModules < g_ModuleNames.size(); g_DefinedModules++)
+            g_BinarySink.defineModule(g_DefinedModules, g_ModuleNames[g_DefinedModules]);
+        for (; g_DefinedSites < g_Sites.size(); g_DefinedSites++)
+        {
+            const LogSite *site = g_Sites[g_DefinedSites];
+            g_BinarySink.defineFormat(site->id, site->moduleID, static_cast<uint8_t>(site->level), site->format);
+        }
+    }
+
+    g_BinarySink.writeRecord(time, static_cast<uint8_t>(level), module, format,
+                             message.substr(sizeof(uint32_t) + sizeof(uint16_t)));
+}
+
+// Encodes a plain message as a record of g_PlainSite
+void encodePlain(std::string &out, std::string_view message)
+{
+    appendBinaryValue(out, g_PlainSite.id);
+    appendBinaryValue(out, g_PlainSite.moduleID);
+    encodeBinaryArgument(out, message);
+}
+
+// Formats one log line onto the output buffer. The caller holds g_ConsumerMutex.
+void appendLine(std::string &output, LogLevel level, std::chrono::system_clock::time_point time, std::string_view message)
+{
+    output += logLevelToColor(level);
+    output += '[';
+    g_Timestamps.append(output, time, g_LoggerConfig.timestampPrecision);
+    output += "] [";
+    output += logLevelToString(level);
+    output += "] ";
+    output += message;
+    output += "\033[0m\n";
+}
+
+// Writes and clears the output buffer. The caller holds g_ConsumerMutex.
+void writeOutput(std::string &output)
+{
+    if (output.empty()) return;
+    std::fwrite(output.data(), 1, output.size(), stdout);
+    std::fflush(stdout);
+    output.clear();
 }
 
 std::string logLevelToString(LogLevel level)
@@ -66,3 +505,15 @@ std::string logLevelToString(LogLevel level)
         default: return "UNKNOWN";
     }
 }
+
+const char *logLevelToColor(LogLevel level)
+{
+    switch (level)
+    {
+        case LogLevel::Debug: return "\033[36m";   // Cyan
+        case LogLevel::Info: return "\033[37m";    // White (default)
+        case LogLevel::Warning: return "\033[33m"; // Yellow
+        case LogLevel::Error: return "\033[31m";   // Red
+        default: return "\033[0m";                 // Reset to default
+    }
+}
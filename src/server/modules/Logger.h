@@ -4,8 +4,18 @@
 
 #pragma once
 #include "ServerModule.h"
+#include "common/Format.h"
+#include "common/BinaryLog.h"
+#include "common/Timestamp.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
 
-enum class LogLevel {
+enum class LogLevel : uint8_t {
     Debug,
     Info,
     Warning,
@@ -13,13 +23,121 @@ enum class LogLevel {
     Fatal
 };
 
+// What a thread does when its log ring is full
+enum class LogOverflow {
+    Drop,   // Discard the message; the writer reports how many were lost
+    Block   // Wait for the writer to make room
+};
+
+// Where the writer puts messages
+enum class LogSink {
+    Text,   // Formatted, colored lines on stdout
+    Binary  // Raw records in memory-mapped files; render them with logdecoder
+};
+
+struct LoggerConfig {
+    LogOverflow overflow = LogOverflow::Drop;
+    size_t ringCapacity = 1024;     // Records per thread (rounded up to a power of two)
+    TimestampPrecision timestampPrecision = TimestampPrecision::Seconds;
+    LogLevel level = LogLevel::Info;                                // Messages below this are discarded
+    std::vector<std::pair<std::string, LogLevel>> moduleLevels;     // Overrides of level for single modules
+    LogSink sink = LogSink::Text;
+    std::string binaryPath = "xserver.binlog";  // Files are named <binaryPath>.<sequence>
+    size_t binaryFileSize = 64 << 20;           // Bytes per file before rotating
+    size_t binaryFileCount = 8;                 // Files kept
+};
+
+// One LOG_* call site. Sites are constant-initialized statics, so checking one costs no guard or lock;
+// each caches whether it is enabled and re-resolves that only after the level configuration changed.
+struct LogSite {
+    const char *module;
+    const char *format;
+    LogLevel level;
+    mutable std::atomic<uint32_t> generation {0};   // Level configuration the cached answer belongs to
+    mutable std::atomic<bool> enabled {false};
+    mutable uint32_t id = 0;                        // Format id in binary logs; assigned on first resolve
+    mutable uint16_t moduleID = 0;
+
+    constexpr LogSite(const char *module, const char *format, LogLevel level)
+            : module(module), format(format), level(level)
+    {}
+};
+
+// Level configuration shared with the inline check in Logger::isEnabled()
+extern std::atomic<LogLevel> g_LogFloor;            // Lowest level any module logs at
+extern std::atomic<uint32_t> g_LogGeneration;       // Bumped on every level change
+extern std::atomic<bool> g_LogBinary;               // The binary sink is active; sites queue raw arguments
+
 class Logger : public ServerModule {
+    LoggerConfig m_Config;
+
 public:
+    explicit Logger(LoggerConfig config = {});
     virtual ~Logger();
     void init() override;
     void run() override;
     std::vector<std::type_index> requiredDependencies() const override { return {}; };
     std::vector<std::type_index> optionalDependencies() const override { return {}; };
 
+    // Queues a message on the calling thread's ring; written synchronously while the writer thread is not running.
+    // Subject to the global level only; prefer the LOG_* macros, which also skip formatting.
     static void log(LogLevel level = LogLevel::Info, const std::string &message = "(empty)");
+
+    // Queues the message of a call site that passed isEnabled(): formatted for the text sink, or as the
+    // site's format id, module id and encoded arguments for the binary sink
+    template<typename... Args>
+    static void log(const LogSite &site, const Args &... args)
+    {
+        thread_local std::string message;
+        message.clear();
+        if (g_LogBinary.load(std::memory_order_relaxed))
+        {
+            appendBinaryValue(message, site.id);
+            appendBinaryValue(message, site.moduleID);
+            (encodeBinaryArgument(message, args), ...);
+            write(site.level, message, true);
+        }
+        else
+        {
+            formatTo(message, site.format, args...);
+            write(site.level, message, false);
+        }
+    }
+
+    // Whether a call site's messages pass the global and module levels
+    static bool isEnabled(const LogSite &site)
+    {
+        if (site.level < g_LogFloor.load(std::memory_order_relaxed)) return false;
+        uint32_t generation = g_LogGeneration.load(std::memory_order_acquire);
+        if (site.generation.load(std::memory_order_acquire) != generation) [[unlikely]]
+            resolve(site, generation);
+        return site.enabled.load(std::memory_order_relaxed);
+    }
+
+    // Level configuration; may be changed at any time from any thread
+    static void setLevel(LogLevel level);
+    static void setModuleLevel(const std::string &module, LogLevel level);
+    static void clearModuleLevel(const std::string &module);
+
+    // Waits until everything logged so far has been written
+    static void flush();
+
+private:
+    static void write(LogLevel level, std::string_view message, bool binary);
+    static void resolve(const LogSite &site, uint32_t generation);
 };
+
+// Logs a message from a module, e.g. LOG_DEBUG("NetworkEngine", "Sent {} bytes to {}", size, client).
+// Nothing after the format string is evaluated unless the message passes the level checks.
+#define LOG_AT(logLevel, module, fmt, ...)                                  \
+    do {                                                                    \
+        static constinit LogSite logSite_ {module, fmt, logLevel};          \
+        if (Logger::isEnabled(logSite_))                                    \
+            Logger::log(logSite_ __VA_OPT__(,) __VA_ARGS__);                \
+    } while (false)
+
+#define LOG_DEBUG(module, fmt, ...) LOG_AT(LogLevel::Debug, module, fmt __VA_OPT__(,) __VA_ARGS__)
+#define LOG_INFO(module, fmt, ...) LOG_AT(LogLevel::Info, module, fmt __VA_OPT__(,) __VA_ARGS__)
+#define LOG_WARNING(module, fmt, ...) LOG_AT(LogLevel::Warning, module, fmt __VA_OPT__(,) __VA_ARGS__)
+#define LOG_ERROR(module, fmt, ...) LOG_AT(LogLevel::Error, module, fmt __VA_OPT__(,) __VA_ARGS__)
+#define LOG_FATAL(module, fmt, ...) LOG_AT(LogLevel::Fatal, module, fmt __VA_OPT__(,) __VA_ARGS__)
@@ -0,0 +1,382 @@
+//
+// Created by msullivan on 12/13/24.
+//
+
+#include "ModuleLoader.h"
+#include "NetworkEngine.h"
+#include "Logger.h"
+#include "modules/ServerModuleAPI.h"
+#include <atomic>
+#include <condition_variable>
+#include <dlfcn.h>
+#include <unistd.h>
+
+// One loaded copy of a module library
+struct LoadedLibrary {
+    void *handle = nullptr;
+    const XServerModule *api = nullptr;
+    void *instance = nullptr;
+    std::atomic<uint32_t> inFlight {0};     // Calls currently inside the module
+    std::atomic<bool> retired {false};      // Replaced or unloaded; no new call may enter
+};
+
+// A module by name. The delegates connected to NetworkEngine's signals point at the slot, so slots stay
+// until the loader is destroyed and so do the libraries loaded into them; a retired library is closed,
+// but its bookkeeping is kept because an emit on another thread may still be about to look at it.
+struct ModuleSlot {
+    std::string name;
+    std::string path;
+    std::filesystem::file_time_type modified;
+    std::atomic<LoadedLibrary *> current {nullptr};
+    std::vector<std::unique_ptr<LoadedLibrary>> libraries;
+    SlotHandle accepted, disconnected, received;    // Connections to NetworkEngine's signals
+};
+
+// Forward declaration(s)
+std::unique_ptr<LoadedLibrary> openLibrary(const std::string &path);
+void closeLibrary(LoadedLibrary &library);
+void retireLibrary(LoadedLibrary &library);
+void connectSlot(ModuleSlot &slot);
+
+// Services offered to modules
+void hostLog(XServerLogLevel level, const char *module, const char *message);
+int hostSend(int connection, const char *data, size_t size);
+size_t hostBroadcast(const char *data, size_t size, int excludeConnection);
+int hostDisconnect(int connection);
+
+const XServerHostAPI g_HostAPI {
+    XSERVER_MODULE_API_VERSION,
+    sizeof(XServerHostAPI),
+    hostLog,
+    hostSend,
+    hostBroadcast,
+    hostDisconnect
+};
+
+std::atomic<uint64_t> g_LibraryCopies = 0;
+
+constexpr auto DRAIN_POLL_INTERVAL = std::chrono::microseconds(100);
+
+ModuleLoader::ModuleLoader(ModuleLoaderConfig config) : m_Config(std::move(config))
+{}
+
+ModuleLoader::~ModuleLoader()
+{
+    // Stop the watcher before unloading what it watches
+    m_Watcher = {};
+
+    std::lock_guard lock(m_Mutex);
+    for (auto &slot : m_Slots)
+    {
+        NetworkEngine::clientAccepted.disconnect(slot->accepted);
+        NetworkEngine::clientDisconnected.disconnect(slot->disconnected);
+        NetworkEngine::receivedData.disconnect(slot->received);
+        if (LoadedLibrary *library = slot->current.exchange(nullptr, std::memory_order_acq_rel))
+            retireLibrary(*library);
+    }
+}
+
+void ModuleLoader::init()
+{
+    // A module that fails to load is reported but does not keep the server from starting
+    for (const auto &path : m_Config.paths)
+        load(path);
+    m_Initialized = true;
+}
+
+void ModuleLoader::run()
+{
+    if (m_Config.reloadInterval > 0)
+        m_Watcher = std::jthread([this](std::stop_token stopToken) { watch(stopToken); });
+    m_Active = true;
+}
+
+std::vector<std::type_index> ModuleLoader::requiredDependencies() const
+{
+    return {typeid(Logger), typeid(NetworkEngine)};
+}
+
+bool ModuleLoader::load(const std::string &path)
+{
+    std::lock_guard lock(m_Mutex);
+    auto library = openLibrary(path);
+    if (!library) return false;
+
+    std::string name = library->api->name;
+    ModuleSlot *slot = findSlot(name);
+    if (slot && slot->current.load(std::memory_order_relaxed))
+    {
+        LOG_ERROR("ModuleLoader", "A module named {} is already loaded (from {})", name, slot->path);
+        closeLibrary(*library);
+        return false;
+    }
+
+    if (!slot)
+    {
+        slot = m_Slots.emplace_back(std::make_unique<ModuleSlot>()).get();
+        slot->name = name;
+        connectSlot(*slot);
+    }
+
+    std::error_code error;
+    slot->path = path;
+    slot->modified = std::filesystem::last_write_time(path, error);
+    slot->current.store(library.get(), std::memory_order_release);
+    slot->libraries.emplace_back(std::move(library));
+
+    LOG_INFO("ModuleLoader", "Loaded module {} from {}", name, path);
+    return true;
+}
+
+bool ModuleLoader::reload(const std::string &name)
+{
+    std::lock_guard lock(m_Mutex);
+    ModuleSlot *slot = findSlot(name);
+    if (!slot || !slot->current.load(std::memory_order_relaxed))
+    {
+        LOG_ERROR("ModuleLoader", "Cannot reload {}: no such module is loaded", name);
+        return false;
+    }
+
+    // Remember this version of the file even if it fails to load, so a broken build is reported once
+    std::error_code error;
+    slot->modified = std::filesystem::last_write_time(slot->path, error);
+
+    auto library = openLibrary(slot->path);
+    if (!library)
+    {
+        LOG_ERROR("ModuleLoader", "Failed to reload {}; keeping the loaded copy", name);
+        return false;
+    }
+    if (name != library->api->name)
+    {
+        LOG_ERROR("ModuleLoader", "Failed to reload {}: {} now contains module {}", name, slot->path, library->api->name);
+        closeLibrary(*library);
+        return false;
+    }
+
+    // New events go to the new copy from here on; the old one is closed once the calls inside it return
+    LoadedLibrary *old = slot->current.exchange(library.get(), std::memory_order_acq_rel);
+    slot->libraries.emplace_back(std::move(library));
+
+    auto start = std::chrono::steady_clock::now();
+    retireLibrary(*old);
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    LOG_INFO("ModuleLoader", "Reloaded module {} from {}; the old copy drained in {} us", name, slot->path, elapsed.count());
+    return true;
+}
+
+bool ModuleLoader::unload(const std::string &name)
+{
+    std::lock_guard lock(m_Mutex);
+    ModuleSlot *slot = findSlot(name);
+    LoadedLibrary *library = slot ? slot->current.exchange(nullptr, std::memory_order_acq_rel) : nullptr;
+    if (!library)
+    {
+        LOG_ERROR("ModuleLoader", "Cannot unload {}: no such module is loaded", name);
+        return false;
+    }
+
+    retireLibrary(*library);
+    LOG_INFO("ModuleLoader", "Unloaded module {}", name);
+    return true;
+}
+
+std::vector<std::string> ModuleLoader::loaded()
+{
+    std::lock_guard lock(m_Mutex);
+    std::vector<std::string> names;
+    for (const auto &slot : m_Slots)
+        if (slot->current.load(std::memory_order_relaxed))
+            names.emplace_back(slot->name);
+    return names;
+}
+
+// The caller holds m_Mutex
+ModuleSlot *ModuleLoader::findSlot(const std::string &name)
+{
+    for (auto &slot : m_Slots)
+        if (slot->name == name)
+            return slot.get();
+    return nullptr;
+}
+
+// Watcher thread; reloads modules whose library file changed
+void ModuleLoader::watch(std::stop_token stopToken)
+{
+    std::mutex mutex;
+    std::condition_variable_any wakeup;
+    while (true)
+    {
+        {
+            std::unique_lock lock(mutex);
+            wakeup.wait_for(lock, stopToken, std::chrono::seconds(m_Config.reloadInterval), [] { return false; });
+        }
+        if (stopToken.stop_requested()) return;
+
+        std::vector<std::string> changed;
+        {
+            std::lock_guard lock(m_Mutex);
+            for (const auto &slot : m_Slots)
+            {
+                std::error_code error;
+                auto modified = std::filesystem::last_write_time(slot->path, error);
+                if (!error && modified != slot->modified && slot->current.load(std::memory_order_relaxed))
+                    changed.emplace_back(slot->name);
+            }
+        }
+
+        for (const auto &name : changed)
+            reload(name);
+    }
+}
+
+// Runs call with the slot's current library, if it has one. A call raises the library's in-flight count
+// before checking that it is not retired, and retiring sets the flag before waiting for the count to drop,
+// so either the call backs off or the retiring thread waits for it (both sides use seq_cst).
+template<typename Call>
+void invokeModule(ModuleSlot &slot, Call &&call)
+{
+    while (LoadedLibrary *library = slot.current.load(std::memory_order_acquire))
+    {
+        library->inFlight.fetch_add(1, std::memory_order_seq_cst);
+        bool live = !library->retired.load(std::memory_order_seq_cst);
+        if (live) call(*library);
+        library->inFlight.fetch_sub(1, std::memory_order_release);
+        if (live) return;
+
+        // Retired after we loaded it; its replacement, if any, is already published
+    }
+}
+
+// Forwards NetworkEngine's events to whatever library the slot holds
+void connectSlot(ModuleSlot &slot)
+{
+    slot.accepted = NetworkEngine::clientAccepted.connect([&slot](Connection connection)
+    {
+        invokeModule(slot, [&](LoadedLibrary &library)
+        {
+            if (library.api->onClientAccepted)
+                library.api->onClientAccepted(library.instance, connection);
+        });
+    });
+    slot.disconnected = NetworkEngine::clientDisconnected.connect([&slot](Connection connection)
+    {
+        invokeModule(slot, [&](LoadedLibrary &library)
+        {
+            if (library.api->onClientDisconnected)
+                library.api->onClientDisconnected(library.instance, connection);
+        });
+    });
+    slot.received = NetworkEngine::receivedData.connect([&slot](Connection connection, const std::string &data)
+    {
+        invokeModule(slot, [&](LoadedLibrary &library)
+        {
+            if (library.api->onReceivedData)
+                library.api->onReceivedData(library.instance, connection, data.data(), data.size());
+        });
+    });
+}
+
+// Opens a private copy of a module library and creates the module. Loading a copy makes dlopen() map the
+// file as it is now, even while an older copy of the same path is still open.
+std::unique_ptr<LoadedLibrary> openLibrary(const std::string &path)
+{
+    std::error_code error;
+    std::filesystem::path copy = std::filesystem::temp_directory_path(error) /
+            ("xserver-module-" + std::to_string(getpid()) + '-' + std::to_string(g_LibraryCopies.fetch_add(1)) + ".so");
+    if (error || !std::filesystem::copy_file(path, copy, std::filesystem::copy_options::overwrite_existing, error))
+    {
+        LOG_ERROR("ModuleLoader", "Failed to load {}: {}", path, error.message());
+        return nullptr;
+    }
+
+    auto library = std::make_unique<LoadedLibrary>();
+    library->handle = dlopen(copy.c_str(), RTLD_NOW | RTLD_LOCAL);
+    std::filesystem::remove(copy, error);
+    if (!library->handle)
+    {
+        LOG_ERROR("ModuleLoader", "Failed to load {}: {}", path, dlerror());
+        return nullptr;
+    }
+
+    auto entry = reinterpret_cast<XServerModuleEntry>(dlsym(library->handle, XSERVER_MODULE_ENTRY));
+    library->api = entry ? entry(XSERVER_MODULE_API_VERSION) : nullptr;
+    if (!library->api)
+    {
+        LOG_ERROR("ModuleLoader", "Failed to load {}: no {} entry point, or it declined this server", path, XSERVER_MODULE_ENTRY);
+        dlclose(library->handle);
+        return nullptr;
+    }
+
+    const XServerModule *api = library->api;
+    if (api->version != XSERVER_MODULE_API_VERSION || api->size < sizeof(XServerModule))
+    {
+        LOG_ERROR("ModuleLoader", "Failed to load {}: built for module API version {}, this server has version {}",
+                  path, api->version, XSERVER_MODULE_API_VERSION);
+        dlclose(library->handle);
+        return nullptr;
+    }
+    if (!api->name || !api->create || !api->destroy)
+    {
+        LOG_ERROR("ModuleLoader", "Failed to load {}: the module lacks a name, create or destroy", path);
+        dlclose(library->handle);
+        return nullptr;
+    }
+
+    library->instance = api->create(&g_HostAPI);
+    if (!library->instance)
+    {
+        LOG_ERROR("ModuleLoader", "Failed to load {}: module {} failed to start", path, api->name);
+        dlclose(library->handle);
+        return nullptr;
+    }
+    return library;
+}
+
+// Destroys a module that was never published and closes its library
+void closeLibrary(LoadedLibrary &library)
+{
+    library.api->destroy(library.instance);
+    dlclose(library.handle);
+    library.instance = nullptr;
+    library.handle = nullptr;
+}
+
+// Stops new calls into a library that is no longer published, waits for the ones inside it, then closes it.
+// Only the calling (management) thread waits; I/O threads never do.
+void retireLibrary(LoadedLibrary &library)
+{
+    library.retired.store(true, std::memory_order_seq_cst);
+    while (library.inFlight.load(std::memory_order_seq_cst) != 0)
+        std::this_thread::sleep_for(DRAIN_POLL_INTERVAL);
+    closeLibrary(library);
+}
+
+void hostLog(XServerLogLevel level, const char *module, const char *message)
+{
+    LogLevel logLevel = LogLevel::Info;
+    switch (level)
+    {
+        case XSERVER_LOG_DEBUG: logLevel = LogLevel::Debug; break;
+        case XSERVER_LOG_INFO: logLevel = LogLevel::Info; break;
+        case XSERVER_LOG_WARNING: logLevel = LogLevel::Warning; break;
+        case XSERVER_LOG_ERROR: logLevel = LogLevel::Error; break;
+    }
+    Logger::log(logLevel, std::string("[") + (module ? module : "?") + "] " + (message ? message : ""));
+}
+
+int hostSend(int connection, const char *data, size_t size)
+{
+    return NetworkEngine::sendData(connection, std::string(data, size)) ? 1 : 0;
+}
+
+size_t hostBroadcast(const char *data, size_t size, int excludeConnection)
+{
+    return NetworkEngine::broadcast(std::make_shared<const std::string>(data, size), excludeConnection);
+}
+
+int hostDisconnect(int connection)
+{
+    return NetworkEngine::disconnect(connection) ? 1 : 0;
+}
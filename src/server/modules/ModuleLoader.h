@@ -0,0 +1,53 @@
+//
+// Created by msullivan on 12/13/24.
+//
+
+#pragma once
+#include "ServerModule.h"
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ModuleSlot;
+
+struct ModuleLoaderConfig {
+    std::vector<std::string> paths;     // Shared libraries to load at startup
+    int reloadInterval = 1;             // Seconds between checks for changed libraries; 0 disables reloading
+};
+
+// Loads modules from shared libraries through the C ABI in include/modules/ServerModuleAPI.h, and reloads
+// them when their files change. Modules receive NetworkEngine's events; a reload swaps the module in place
+// without disconnecting clients, and the I/O threads never wait for it.
+class ModuleLoader : public ServerModule {
+    ModuleLoaderConfig m_Config;
+    std::mutex m_Mutex;                                 // Serializes loading, reloading and unloading
+    std::vector<std::unique_ptr<ModuleSlot>> m_Slots;   // Never shrinks; signal slots point into it
+    std::jthread m_Watcher;
+
+    ModuleSlot *findSlot(const std::string &name);
+    void watch(std::stop_token stopToken);
+
+public:
+    explicit ModuleLoader(ModuleLoaderConfig config = {});
+    ~ModuleLoader() override;
+    void init() override;
+    void run() override;
+    [[nodiscard]] std::vector<std::type_index> requiredDependencies() const override;
+    [[nodiscard]] std::vector<std::type_index> optionalDependencies() const override { return {}; }
+
+    // Loads a module library; returns false if it cannot be loaded or a module of that name is loaded
+    bool load(const std::string &path);
+
+    // Replaces a loaded module with a fresh copy of its library; the old one stays if that fails
+    bool reload(const std::string &name);
+
+    // Unloads a module once calls into it have returned
+    bool unload(const std::string &name);
+
+    // Names of the loaded modules
+    [[nodiscard]] std::vector<std::string> loaded();
+};
@@ -4,9 +4,16 @@
 
 #include "NetworkEngine.h"
 #include "server/Server.h"
+#include "common/Frame.h"
 #include "common/Message.h"
+#include "SendQueue.h"
+#include "TimerWheel.h"
+#include "FDIndex.h"
+#include "AsyncConnection.h"
 #include <future>
-#include <barrier>
+#include <optional>
+#include <charconv>
+#include <memory_resource>
 #include <fcntl.h>
 #include <entt/entt.hpp>
 
@@ -14,7 +21,13 @@
 
 #ifndef _WIN32
 #include <arpa/inet.h>
+#include <netinet/tcp.h>
 #include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
 #else
 #include <winsock2.h>
 #include <ws2tcpip.h>
@@ -51,35 +64,117 @@ struct Metrics {
     size_t bytesReceived = 0;
 };
 
+// Per-connection read buffer; bytes are only handed to receivedData once a whole frame has arrived
+struct ReadBuffer {
+    FrameBuffer frames;
+};
+
+// Tags a connection that is being torn down so disconnect() only runs once
+struct Disconnecting {};
+
+/* Reactor */
+// Each I/O worker owns a listening socket bound with SO_REUSEPORT, an epoll set and the slice of
+// connections the kernel handed to that socket. Its mutex only guards its own registry.
+struct Reactor {
+    size_t id = 0;
+    int epollFD = -1;
+    int wakeupFD = -1;
+    Connection listener = -1;
+    entt::registry registry;
+    std::mutex mutex;
+    std::thread thread;
+
+    // Accept counters; written by the reactor thread, read by acceptStats()
+    std::atomic<size_t> accepted = 0;
+    std::atomic<size_t> backlogOverflows = 0;
+    std::atomic<double> acceptRate = 0;
+    size_t acceptedAtLastTick = 0;
+    size_t overflowsAtLastTick = 0;
+
+    // Scratch memory for slots running on this thread (NetworkEngine::frameArena()); released after every
+    // batch of events. Only allocations beyond the inline buffer reach the heap.
+    alignas(std::max_align_t) std::byte arenaBuffer[64 * 1024];
+    std::pmr::monotonic_buffer_resource arena {arenaBuffer, sizeof(arenaBuffer)};
+
+    // Expiry timers for this reactor's clients, keyed by fd; guarded by mutex
+    TimerWheel timers {std::chrono::milliseconds(100)};
+    std::vector<uint32_t> expired;
+};
+
+// Locked view of a single connection inside its owning reactor
+struct ConnectionRef {
+    Reactor *reactor = nullptr;
+    entt::entity entity = entt::null;
+    std::unique_lock<std::mutex> lock;
+
+    explicit operator bool() const { return reactor != nullptr; }
+    template<typename T> T &get() { return reactor->registry.get<T>(entity); }
+    template<typename T> [[nodiscard]] bool has() const { return reactor->registry.all_of<T>(entity); }
+};
+
 // Global variables
-entt::registry g_ConnectionRegistry;
-Connection g_ServerConnection;
+NetworkConfig g_NetworkConfig;
+std::vector<std::unique_ptr<Reactor>> g_Reactors;
+Connection g_ServerConnection = -1;
+std::atomic<size_t> g_ClientCount = 0;
 
-std::mutex g_NetworkEngineMutex;
-std::condition_variable g_NetworkEngineCV;
+// fd -> (reactor, entity); sized from RLIMIT_NOFILE in init()
+FDIndex<Reactor, entt::entity, static_cast<entt::entity>(entt::null)> g_FDIndex;
+constexpr size_t MAX_FD_INDEX_SIZE = 1 << 20;
 
-std::thread acceptorThread;
-std::thread eventThread;
+constexpr int MAX_EVENTS_PER_WAIT = 256;
+constexpr int REACTOR_TICK_MS = 1000;      // Upper bound on how long epoll_wait() blocks
+constexpr int KEEPALIVE_PROBES = 3;       // Unanswered TCP keepalive probes before the kernel drops a peer
+constexpr size_t RECEIVE_CHUNK_SIZE = 16 * 1024;
+constexpr size_t MAX_IOV_PER_WRITE = 64;
 
-std::mutex g_NetworkThreadMutex;
-std::barrier g_NetworkThreadBarrier(2);
+// Reactor the current thread runs, if any
+thread_local Reactor *t_Reactor = nullptr;
 
-// Forward declaration(s)
-void validateConnections();
-void processConnections();
-void processConnectionsInternal(const std::function<bool(Connection)> &predicate);
+// A peer resetting its socket must not SIGPIPE the whole server
+#ifndef _WIN32
+constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+constexpr int SEND_FLAGS = 0;
+#endif
 
-Connection createConnection(bool, int);
-entt::entity createConnectionEntity(int, sockaddr_in, bool);
+// Forward declaration(s)
+void expireConnections(Reactor &reactor, std::chrono::steady_clock::time_point now);
+std::optional<std::chrono::steady_clock::time_point> expiryDeadline(ConnectionRef &connection);
+void armExpiry(ConnectionRef &connection);
+
+bool createReactor(Reactor &reactor, int port);
+void destroyReactor(Reactor &reactor);
+void wakeReactor(Reactor &reactor);
+void runReactor(const ServerModule &engine, Reactor &reactor);
+void tickReactor(Reactor &reactor, std::chrono::steady_clock::time_point &lastTick);
+void handleEvent(Reactor &reactor, const epoll_event &event);
+bool watchConnection(Reactor &reactor, int fd);
+
+Connection createListener(Reactor &reactor, int port);
+entt::entity createConnectionEntity(Reactor &, int, sockaddr_in, bool);
+void destroyConnectionEntity(Reactor &, entt::entity);
+void createFDIndex();
 int createAndConfigureSocket(bool isServer, int port);
 bool createServerAddress(sockaddr_in &address, int port);
 bool bindAddress(int serverFD, sockaddr_in serverAddress);
-bool startListening(int serverFD);
-bool acceptClient();
+bool startListening(int serverFD, int backlog);
+bool acceptClient(Reactor &reactor);
+bool isAcceptQueueFull(int listenerFD);
 
-Connection entityToFD(entt::entity entity);
-entt::entity fdToEntity(Connection connection);
+Connection entityToFD(Reactor &reactor, entt::entity entity);
+ConnectionRef lockConnection(Connection connection);
+entt::entity findConnection(Reactor &reactor, Connection connection);
 bool isValid(Connection connection);
+void closeConnection(ConnectionRef &connection);
+bool extractFrames(ConnectionRef &connection, size_t received, std::vector<std::string> &frames);
+void dispatchFrames(Connection connection, const std::vector<std::string> &frames, bool protocolError, bool peerClosed);
+
+enum class FlushResult { Drained, Pending, Failed };
+FlushResult flushSendQueue(ConnectionRef &connection);
+bool enqueueFrame(ConnectionRef &connection, SharedPayload payload, bool &backpressureChanged);
+bool flushConnection(Connection connection);
+bool updateBackpressure(ConnectionRef &connection);
 
 // Static signal definitions
 Signal<> NetworkEngine::started;
@@ -88,50 +183,44 @@ Signal<Connection> NetworkEngine::clientAccepted;
 Signal<Connection> NetworkEngine::clientDisconnected;
 Signal<Connection, const std::string &> NetworkEngine::sentData;
 Signal<Connection, const std::string &> NetworkEngine::receivedData;
-Signal<Connection, const std::string &> NetworkEngine::broadcastData;
+Signal<Connection, const Message &> NetworkEngine::broadcastData;
 Signal<Connection> NetworkEngine::receivedKeepalive;
+Signal<Connection, bool> NetworkEngine::backpressure;
 
 // Static slots definitions
 void NetworkEngine::onAccept(Connection connection)
 {
-    std::string ip = getIP(connection);
-    std::string port = std::to_string(getPort(connection));
-    std::string message = "Client @ " + ip + ':' + port + " connected";
-    Logger::log(LogLevel::Info, message);
-    broadcastData(std::move(connection), message);
+    std::pmr::memory_resource *arena = frameArena();
+    char buffer[ADDRESS_LENGTH];
+    std::string_view address = getAddress(connection, buffer);
+    std::pmr::string message(arena);
+    message.append("Client @ ").append(address).append(" connected");
+    LOG_INFO("NetworkEngine", "Client @ {} connected", address);
+    broadcastData(Connection(connection), Message(connection, message, std::chrono::system_clock::now(), arena));
 }
 
 void NetworkEngine::onDisconnect(Connection connection)
 {
-    std::string ip = getIP(connection);
-    std::string port = std::to_string(getPort(connection));
-    std::string message = "Client @ " + ip + ':' + port + " disconnected";
-    Logger::log(LogLevel::Info, message);
-    broadcastData(std::move(connection), message);
+    std::pmr::memory_resource *arena = frameArena();
+    char buffer[ADDRESS_LENGTH];
+    std::string_view address = getAddress(connection, buffer);
+    std::pmr::string message(arena);
+    message.append("Client @ ").append(address).append(" disconnected");
+    LOG_INFO("NetworkEngine", "Client @ {} disconnected", address);
+    broadcastData(Connection(connection), Message(connection, message, std::chrono::system_clock::now(), arena));
 }
 
 void NetworkEngine::onSentData(Connection connection, const std::string &data)
 {
-    std::string ip = getIP(connection);
-    std::string port = std::to_string(getPort(connection));
-    std::string message = "Sent \"" + data + "\" to client @ " + ip + ':' + port;
-    Logger::log(LogLevel::Info, message);
+    // The address lookups lock the connection's reactor, so they only happen if the message is written
+    LOG_INFO("NetworkEngine", "Sent \"{}\" to client @ {}:{}", data, getIP(connection), getPort(connection));
 }
 
 void NetworkEngine::onReceivedData(Connection connection, const std::string &data)
 {
     if (data[0] == '/')
     {
-        //        auto commandSubsystem = dynamic_cast<CommandManager *>(Server::instance().subsystem("CommandManager"));
-        //        auto it = commandSubsystem->find(message);
-        //        if (it != commandSubsystem->end())
-        //        {
-        //            auto command = it->second.operator()();
-        //            command->execute(message);
-        //            delete command;
-        //        }
-
-        // CommandProcessor::receiveCommand(std::move(sender), message);
+        // Slash commands are CommandManager's
     }
     else if (data == "KEEPALIVE")
     {
@@ -139,42 +228,61 @@ void NetworkEngine::onReceivedData(Connection connection, const std::string &dat
     }
     else
     {
-        std::string ip = getIP(connection);
-        std::string port = std::to_string(getPort(connection));
-        std::string message = "Client @ " + ip + ':' + port + ": \"" + data + '"';
-        Logger::log(LogLevel::Info, message);
-        broadcastData(std::move(connection), message);
+        // Scratch strings come from the reactor's arena and are released with the rest of this batch
+        std::pmr::memory_resource *arena = frameArena();
+        char buffer[ADDRESS_LENGTH];
+        std::string_view address = getAddress(connection, buffer);
+        std::pmr::string message(arena);
+        message.reserve(address.size() + data.size() + 16);
+        message.append("Client @ ").append(address).append(": \"").append(data).append("\"");
+        LOG_INFO("NetworkEngine", "Client @ {}: \"{}\"", address, data);
+        broadcastData(Connection(connection), Message(connection, message, std::chrono::system_clock::now(), arena));
     }
 }
 
 void NetworkEngine::onReceivedKeepalive(Connection connection)
+{
+    LOG_DEBUG("NetworkEngine", "Received keepalive from client @ {}:{}", getIP(connection), getPort(connection));
+}
+
+void NetworkEngine::onBackpressure(Connection connection, bool throttled)
 {
     std::string ip = getIP(connection);
     std::string port = std::to_string(getPort(connection));
-    Logger::log(LogLevel::Debug, "Received keepalive from client @ " + ip + ':' + port);
+    if (throttled)
+        LOG_WARNING("NetworkEngine", "Client @ {}:{} is not keeping up; send queue above high watermark", ip, port);
+    else
+        LOG_INFO("NetworkEngine", "Client @ {}:{} caught up; send queue below low watermark", ip, port);
 }
 
+NetworkEngine::NetworkEngine(NetworkConfig config) : m_Config(config)
+{}
+
 NetworkEngine::~NetworkEngine()
 {
-    // Stop and join the event loop
+    // Stop and join the event loops
     m_Active = false;
-    g_NetworkEngineCV.notify_all();
+    for (auto &reactor : g_Reactors)
+        wakeReactor(*reactor);
 
-    if (acceptorThread.joinable()) acceptorThread.join();     // Wait for acceptor coroutine to finish
-    if (eventThread.joinable()) eventThread.join();           // Wait for event coroutine to finish
+    for (auto &reactor : g_Reactors)
+        if (reactor->thread.joinable()) reactor->thread.join();   // Wait for the reactor to finish
 
 #ifdef WIN32
     WSACleanup();
 #endif
 
     // Cleanup connections
-    auto clients = g_ConnectionRegistry.view<ClientConnection>();
-    for (auto client : clients)
-        disconnect(entityToFD(client));
+    for (auto client : clients())
+        disconnect(client);
+
+    for (auto &reactor : g_Reactors)
+        destroyReactor(*reactor);
 
-    g_ConnectionRegistry.clear();
+    g_Reactors.clear();
+    g_FDIndex.reset(0);
 
-    Logger::log(LogLevel::Info, "Network engine Stopped");
+    LOG_INFO("NetworkEngine", "Network engine Stopped");
 }
 
 void NetworkEngine::init()
@@ -183,35 +291,40 @@ void NetworkEngine::init()
     // Start Winsock
     WSAData wsaData {};
     if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
-        Logger::log(LogLevel::Fatal, "WSAStartup failed");
+        LOG_FATAL("NetworkEngine", "WSAStartup failed");
 #endif
 
-    // Create the server connection
-    int port = 8000;
-    Connection serverFD = createConnection(true, port);
-    if (serverFD == -1)
-    {
-        Logger::log(LogLevel::Fatal, "Failed to create server connection");
-        exit(EXIT_FAILURE);
-    }
-    Logger::log(LogLevel::Info, "Created server socket: " + std::to_string(serverFD));
+    g_NetworkConfig = m_Config;
+    createFDIndex();
 
-    // Get the server entity from the file descriptor
-    auto serverEntity = fdToEntity(serverFD);
+    // Create one reactor per I/O worker; each one binds its own listening socket to the same port
+    unsigned int workers = m_Config.workers ? m_Config.workers : std::max(1u, std::thread::hardware_concurrency());
+    int port = m_Config.port;
 
-    // Verify server entity has been set up correctly
-    if (!g_ConnectionRegistry.valid(serverEntity))
+    for (unsigned int i = 0; i < workers; i++)
     {
-        Logger::log(LogLevel::Fatal, "Server entity creation failed");
-        exit(EXIT_FAILURE);
-    }
+        auto reactor = std::make_unique<Reactor>();
+        reactor->id = i;
 
-    // Log server initialization details
-    std::string ip = getIP(serverFD);
-    Logger::log(LogLevel::Info, "Server initialized and listening on " + ip + ':' + std::to_string(port));
+        if (!createReactor(*reactor, port))
+        {
+            LOG_FATAL("NetworkEngine", "Failed to create network reactor #{}", i);
+            exit(EXIT_FAILURE);
+        }
+
+        // If the port was picked by the kernel, the remaining workers have to share it
+        if (port == 0)
+            port = getPort(reactor->listener);
+
+        g_Reactors.emplace_back(std::move(reactor));
+    }
 
     // Store server connection globally
-    g_ServerConnection = serverFD;
+    g_ServerConnection = g_Reactors.front()->listener;
+
+    // Log server initialization details
+    std::string ip = getIP(g_ServerConnection);
+    LOG_INFO("NetworkEngine", "Server initialized and listening on {}:{} with {} I/O worker(s)", ip, port, workers);
 
     // Connect the signals to slots
     clientAccepted.connect(onAccept);
@@ -220,70 +333,52 @@ void NetworkEngine::init()
     receivedData.connect(onReceivedData);
     receivedKeepalive.connect(onReceivedKeepalive);
     broadcastData.connect(onReceivedBroadcast);
+    backpressure.connect(onBackpressure);
 
     m_Initialized = true;
     m_Active = true;
 }
 
-void NetworkEngine::run()
+std::vector<std::type_index> NetworkEngine::requiredDependencies() const
 {
-    // Start acceptor thread
-    acceptorThread = std::thread([this]
-    {
-        g_NetworkThreadBarrier.arrive_and_wait();
-
-        Logger::log(LogLevel::Info, "Started client acceptor thread");
-        while (isActive())
-        {
-            if (acceptClient())
-                g_NetworkEngineCV.notify_one(); // Notify the event thread
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
-        }
-    });
+    return {typeid(Logger)};
+}
 
-    // Start event thread
-    eventThread = std::thread([this]
+void NetworkEngine::run()
+{
+    // Start one event thread per reactor
+    for (auto &reactor : g_Reactors)
     {
-        g_NetworkThreadBarrier.arrive_and_wait();
-
-        Logger::log(LogLevel::Info, "Started event thread");
-        while (isActive())
+        reactor->thread = std::thread([this, target = reactor.get()]
         {
-            std::unique_lock lock(g_NetworkThreadMutex);
-            g_NetworkEngineCV.wait(lock, [this] {
-                return !isActive() || size() > 0;
-            });
-            if (!isActive()) break;
-            lock.unlock();
-
-            validateConnections();
-            processConnections();
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        }
-        Logger::log(LogLevel::Info, "Stopped event thread");
-    });
+            LOG_INFO("NetworkEngine", "Started event thread #{}", target->id);
+            runReactor(*this, *target);
+            LOG_INFO("NetworkEngine", "Stopped event thread #{}", target->id);
+        });
+    }
 }
 
-void NetworkEngine::onReceivedBroadcast(Connection sender, const std::string &data)
+void NetworkEngine::onReceivedBroadcast(Connection sender, const Message &message)
 {
-    // Construct message
-    std::string ip  = getIP(sender);
-    int port = getPort(sender);
-    std::string body = "Client @ " + ip + ':' + std::to_string(port) + " sent: \"" + data + '"';
-    Message message(ip, port, body);
-
-    // Send message to all client other than the sender
-    auto clientEnts = g_ConnectionRegistry.view<ClientConnection>();
-    for (auto clientEnt : clientEnts)
-    {
-        auto client = entityToFD(clientEnt);
-        if (sender == client) continue; // Skip sender
+    std::pmr::memory_resource *arena = frameArena();
+    char buffer[ADDRESS_LENGTH];
+    std::string_view address = getAddress(sender, buffer);
+
+    std::pmr::string text(arena);
+    text.reserve(address.size() + message.content().size() + 16);
+    text.append("Client @ ").append(address).append(" sent: \"").append(message.content()).append("\"");
+
+    // The payload outlives this batch in the send queues, so it is encoded once on the heap and shared
+    auto payload = std::make_shared<std::string>();
+    Message(message.senderID(), text, message.time(), arena).encode(*payload);
+    size_t recipients = broadcast(std::move(payload), sender);
+    LOG_INFO("NetworkEngine", "Broadcast message from client @ {} to {} client(s): \"{}\"", address, recipients,
+             message.content());
+}
 
-        // Attempt to send data
-        sendData(client, message.content());
-    }
-    Logger::log(LogLevel::Info, "Broadcast message from client @ " + ip + ':' + std::to_string(port) +
-                                 ": \"" + data + '"');
+std::pmr::memory_resource *NetworkEngine::frameArena()
+{
+    return t_Reactor ? &t_Reactor->arena : std::pmr::get_default_resource();
 }
 
 [[nodiscard]] Connection NetworkEngine::getServer()
@@ -294,170 +389,291 @@ void NetworkEngine::onReceivedBroadcast(Connection sender, const std::string &da
 [[nodiscard]] std::vector<Connection> NetworkEngine::clients()
 {
     std::vector<Connection> connections;
-    for (auto client : g_ConnectionRegistry.view<ClientConnection>())
-        connections.emplace_back(entityToFD(client));
+    connections.reserve(size());
+    for (auto &reactor : g_Reactors)
+    {
+        std::lock_guard lock(reactor->mutex);
+        for (auto client : reactor->registry.view<ClientConnection>())
+            if (!reactor->registry.all_of<Disconnecting>(client))
+                connections.emplace_back(entityToFD(*reactor, client));
+    }
     return connections;
 }
 
 [[nodiscard]] size_t NetworkEngine::size()
 {
-    return g_ConnectionRegistry.view<ClientConnection>().size();
+    return g_ClientCount.load(std::memory_order_relaxed);
 }
 
 [[nodiscard]] bool NetworkEngine::empty()
 {
-    return g_ConnectionRegistry.view<ClientConnection>().empty();
+    return size() == 0;
+}
+
+[[nodiscard]] AcceptStats NetworkEngine::acceptStats()
+{
+    AcceptStats stats;
+    for (auto &reactor : g_Reactors)
+    {
+        stats.accepted += reactor->accepted.load(std::memory_order_relaxed);
+        stats.backlogOverflows += reactor->backlogOverflows.load(std::memory_order_relaxed);
+        stats.acceptRate += reactor->acceptRate.load(std::memory_order_relaxed);
+    }
+    return stats;
 }
 
 bool NetworkEngine::sendData(Connection sender, const std::string &data)
 {
-    if (!isValid(sender)) [[unlikely]] return false;
+    // Don't do anything if the data is empty
+    if (data.empty()) [[unlikely]] return false;
 
-    auto &socket = g_ConnectionRegistry.get<SocketInfo>(fdToEntity(sender));
-    auto &metrics = g_ConnectionRegistry.get<Metrics>(fdToEntity(sender));
+    if (!sendData(sender, std::make_shared<const std::string>(data))) return false;
+    sentData(std::move(sender), data);
+    return true;
+}
 
-    // Don't do anything if the socket is invalid or data is empty
-    if (socket.fd == -1 || data.empty()) [[unlikely]] return false;
+bool NetworkEngine::sendData(Connection sender, SharedPayload payload)
+{
+    if (!payload || payload->empty()) [[unlikely]] return false;
 
-    // Attempt to send data
-    std::unique_lock lock(g_NetworkEngineMutex);
-    ssize_t bytesSent = send(socket.fd, data.c_str(), data.length(), 0);
-    if (bytesSent == -1)
+    bool backpressureChanged = false;
+    bool throttled;
     {
-#ifndef _WIN32
-        Logger::log(LogLevel::Error, "Error sending data: " + std::string(strerror(errno)));
-#else
-        Logger::log(LogLevel::Error, "Error sending data: " + std::to_string(WSAGetLastError()));
-#endif
-        return false;
+        auto connection = lockConnection(sender);
+        if (!connection || !connection.has<SendQueue>()) [[unlikely]] return false;
+
+        if (!enqueueFrame(connection, std::move(payload), backpressureChanged)) return false;
+        throttled = connection.get<SendQueue>().throttled;
     }
-    metrics.bytesSent += data.size();
-    lock.unlock();
 
-    sentData(std::move(sender), data);
+    if (backpressureChanged)
+        backpressure(std::move(sender), bool(throttled));
     return true;
 }
 
-std::string NetworkEngine::receiveData(Connection connection)
+// Queues one payload on every client except the excluded one; returns the number of recipients.
+// Each reactor is locked once for all of its clients and the payload is shared, not copied.
+size_t NetworkEngine::broadcast(SharedPayload payload, Connection exclude)
 {
-    if (!isValid(connection) || !hasPendingData(connection)) [[unlikely]] return "";
+    if (!payload || payload->empty()) [[unlikely]] return 0;
 
-    auto &socket = g_ConnectionRegistry.get<SocketInfo>(fdToEntity(connection));
-
-    std::unique_lock lock(g_NetworkEngineMutex);
-    char buffer[1024] {};
-    ssize_t bytesReceived = recv(socket.fd, buffer, sizeof(buffer), 0);
-
-    if (bytesReceived == 0)
+    size_t recipients = 0;
+    std::vector<std::pair<Connection, bool>> backpressureChanges;
+    for (auto &reactor : g_Reactors)
     {
-        Logger::log(LogLevel::Info, "Connection closed by peer");
-        disconnect(connection);
-        return "";
+        std::lock_guard lock(reactor->mutex);
+        auto &registry = reactor->registry;
+        for (auto entity : registry.view<ClientConnection>())
+        {
+            int fd = registry.get<SocketInfo>(entity).fd;
+            if (fd == exclude || registry.all_of<Disconnecting>(entity)) continue;
+
+            // The lock is already held, so the reference carries none of its own
+            ConnectionRef connection {reactor.get(), entity, {}};
+            bool backpressureChanged = false;
+            if (!enqueueFrame(connection, payload, backpressureChanged)) continue;
+            if (backpressureChanged)
+                backpressureChanges.emplace_back(fd, registry.get<SendQueue>(entity).throttled);
+            recipients++;
+        }
     }
-    lock.unlock();
 
-    if (bytesReceived < 0)
+    // Signals are emitted after every reactor lock has been released
+    for (auto [connection, throttled] : backpressureChanges)
+        backpressure(Connection(connection), bool(throttled));
+    return recipients;
+}
+
+std::vector<std::string> NetworkEngine::receiveData(Connection connection)
+{
+    std::vector<std::string> frames;
+    bool peerClosed = false;
+    bool protocolError = false;
+
     {
+        auto ref = lockConnection(connection);
+        if (!ref || !ref.has<ReadBuffer>()) [[unlikely]] return frames;
+
+        auto &socket = ref.get<SocketInfo>();
+        auto &buffer = ref.get<ReadBuffer>().frames;
+
+        // Sockets are edge-triggered, so drain everything the kernel has buffered
+        size_t totalReceived = 0;
+        while (true)
+        {
+            auto space = buffer.prepare(RECEIVE_CHUNK_SIZE);
+            ssize_t bytesReceived = recv(socket.fd, space.data(), space.size(), 0);
+            if (bytesReceived > 0)
+            {
+                buffer.commit(bytesReceived);
+                totalReceived += bytesReceived;
+                continue;
+            }
+
+            if (bytesReceived == 0)
+            {
+                peerClosed = true;
+                break;
+            }
+
 #ifndef _WIN32
-        Logger::log(LogLevel::Error, "Error receiving data: " + std::string(strerror(errno)));
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                LOG_ERROR("NetworkEngine", "Error receiving data: {}", strerror(errno));
+                peerClosed = true;
+            }
 #else
-        Logger::log(LogLevel::Error, "Error receiving data: " + std::to_string(WSAGetLastError()));
+            if (WSAGetLastError() != WSAEWOULDBLOCK)
+            {
+                LOG_ERROR("NetworkEngine", "Error receiving data: {}", WSAGetLastError());
+                peerClosed = true;
+            }
 #endif
-        return "";
+            break;
+        }
+
+        protocolError = !extractFrames(ref, totalReceived, frames);
     }
 
+    dispatchFrames(connection, frames, protocolError, peerClosed);
+    return frames;
+}
+
+// Splits every complete frame off a connection's read buffer and records the activity. Returns false
+// if the peer sent a frame above the size limit. The caller holds the reactor's mutex.
+bool extractFrames(ConnectionRef &connection, size_t received, std::vector<std::string> &frames)
+{
+    auto &buffer = connection.get<ReadBuffer>().frames;
+
+    // A partial frame stays buffered for the next read
+    std::string_view payload;
+    FrameBuffer::Status status;
+    while ((status = buffer.next(payload, g_NetworkConfig.maxFrameSize)) == FrameBuffer::Status::Frame)
+        if (!payload.empty())
+            frames.emplace_back(payload);
+
     // Update the last activity time if client connection
-    lock.lock();
-    if (connection != g_ServerConnection) [[likely]]
+    if (received > 0)
     {
-        auto &clientInfo = g_ConnectionRegistry.get<ClientInfo>(fdToEntity(connection));
-        clientInfo.lastActivityTime = std::chrono::steady_clock::now();
+        if (connection.has<ClientConnection>()) [[likely]]
+            connection.get<ClientInfo>().lastActivityTime = std::chrono::steady_clock::now();
+
+        connection.get<Metrics>().bytesReceived += received;
     }
+    return status != FrameBuffer::Status::TooLarge;
+}
 
-    auto &metrics = g_ConnectionRegistry.get<Metrics>(fdToEntity(connection));
-    metrics.bytesReceived += bytesReceived;
-    lock.unlock();
+// Hands received frames to the slots, then tears the connection down if the peer misbehaved or left
+void dispatchFrames(Connection connection, const std::vector<std::string> &frames, bool protocolError, bool peerClosed)
+{
+    for (const auto &frame : frames)
+        if (!deliverAsyncFrame(connection, frame))
+            NetworkEngine::receivedData(Connection(connection), frame);
 
-    receivedData(std::move(connection), buffer);
-    return std::string(buffer, bytesReceived);
+    if (protocolError)
+    {
+        LOG_WARNING("NetworkEngine", "Client {} sent a frame larger than {} bytes; disconnecting",
+                    connection, g_NetworkConfig.maxFrameSize);
+        NetworkEngine::disconnect(connection);
+    }
+    else if (peerClosed)
+    {
+        LOG_INFO("NetworkEngine", "Connection closed by peer");
+        NetworkEngine::disconnect(connection);
+    }
 }
 
 bool NetworkEngine::disconnect(Connection client)
 {
-    if (!isValid(client) || client == g_ServerConnection) [[unlikely]] return false;
+    {
+        auto connection = lockConnection(client);
+        if (!connection || connection.has<ServerConnection>()) [[unlikely]] return false;
 
-    // Remove connection from registry
-    clientDisconnected(std::move(client));
+        // Another path is already tearing this connection down
+        if (connection.has<Disconnecting>()) return false;
+        connection.reactor->registry.emplace<Disconnecting>(connection.entity);
+    }
 
-    // Close client socket
-    if (getFD(client) != -1) [[unlikely]]
-#ifndef _WIN32
-        close(getFD(client));
-#else
-        closesocket(socket.fd);
-#endif
+    // Let slots inspect the connection before it goes away
+    clientDisconnected(Connection(client));
 
-    g_ConnectionRegistry.destroy(fdToEntity(client));
+    auto connection = lockConnection(client);
+    if (!connection) [[unlikely]] return false;
+
+    closeConnection(connection);
     return true;
 }
 
-[[nodiscard]] bool NetworkEngine::hasPendingData(Connection client)
+// Destroys a connection's entity and closes its socket. The caller holds the reactor's mutex.
+void closeConnection(ConnectionRef &connection)
 {
-    if (!isValid(client)) [[unlikely]] return false;
+    auto fd = connection.get<SocketInfo>().fd;
+    destroyConnectionEntity(*connection.reactor, connection.entity);
 
-    auto entity = fdToEntity(client);
-    if (entity == entt::null)
-    {
-        Logger::log(LogLevel::Error, "Invalid entity for client connection " + client);
-        return false;
-    }
-
-    auto &socket = g_ConnectionRegistry.get<SocketInfo>(fdToEntity(client));
-    if (socket.fd == -1)
+    if (fd != -1) [[likely]]
+#ifndef _WIN32
     {
-        Logger::log(LogLevel::Error, "Invalid file descriptor for client " + client);
-        return false;
+        if (connection.reactor->epollFD != -1)
+            epoll_ctl(connection.reactor->epollFD, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
     }
+#else
+        closesocket(fd);
+#endif
 
-    fd_set readFDs;
-    FD_ZERO(&readFDs);
-    FD_SET(socket.fd, &readFDs);
-
-    timeval timeout = {0, 0};
-    int result = select(socket.fd + 1, &readFDs, nullptr, nullptr, &timeout);
-
-    if (result > 0 && FD_ISSET(socket.fd, &readFDs)) return true;
-    return false;
+    g_ClientCount.fetch_sub(1, std::memory_order_relaxed);
 }
 
 [[nodiscard]] long NetworkEngine::getFD(Connection connection)
 {
-    if (!isValid(connection)) [[unlikely]] return false;
-    return g_ConnectionRegistry.get<SocketInfo>(fdToEntity(connection)).fd;
+    auto ref = lockConnection(connection);
+    if (!ref) [[unlikely]] return false;
+    return ref.get<SocketInfo>().fd;
 }
 
 [[nodiscard]] std::string NetworkEngine::getIP(Connection connection)
 {
-    if (!isValid(connection)) [[unlikely]] return "";
+    auto ref = lockConnection(connection);
+    if (!ref) [[unlikely]] return "";
 
-    auto &socket = g_ConnectionRegistry.get<SocketInfo>(fdToEntity(connection));
+    auto &socket = ref.get<SocketInfo>();
     char ipStr[INET_ADDRSTRLEN];
     inet_ntop(AF_INET, &(socket.address.sin_addr), ipStr, INET_ADDRSTRLEN);
     return ipStr;
 }
 
+std::string_view NetworkEngine::getAddress(Connection connection, char (&buffer)[ADDRESS_LENGTH])
+{
+    static_assert(ADDRESS_LENGTH >= INET_ADDRSTRLEN + 6);
+    sockaddr_in address;
+    {
+        auto ref = lockConnection(connection);
+        if (!ref) [[unlikely]] return {};
+        address = ref.get<SocketInfo>().address;
+    }
+
+    inet_ntop(AF_INET, &address.sin_addr, buffer, INET_ADDRSTRLEN);
+    size_t length = std::strlen(buffer);
+    buffer[length++] = ':';
+    length = std::to_chars(buffer + length, buffer + ADDRESS_LENGTH, ntohs(address.sin_port)).ptr - buffer;
+    return {buffer, length};
+}
+
 [[nodiscard]] int NetworkEngine::getPort(Connection connection)
 {
-    if (!isValid(connection)) [[unlikely]] return -1;
-    return ntohs(g_ConnectionRegistry.get<SocketInfo>(fdToEntity(connection)).address.sin_port);
+    auto ref = lockConnection(connection);
+    if (!ref) [[unlikely]] return -1;
+    return ntohs(ref.get<SocketInfo>().address.sin_port);
 }
 
 [[nodiscard]] bool NetworkEngine::isActiveConnection(Connection connection, int timeout)
 {
-    if (!isValid(connection)) [[unlikely]] return false;
-    if (connection == g_ServerConnection) [[unlikely]] return true;
+    auto ref = lockConnection(connection);
+    if (!ref) [[unlikely]] return false;
+    if (ref.has<ServerConnection>()) [[unlikely]] return true;
 
-    auto &clientInfo = g_ConnectionRegistry.get<ClientInfo>(fdToEntity(connection));
+    auto &clientInfo = ref.get<ClientInfo>();
 
     auto currentTime = std::chrono::steady_clock::now();
     bool isActive = (currentTime - clientInfo.lastActivityTime) < std::chrono::seconds(timeout);
@@ -466,167 +682,516 @@ bool NetworkEngine::disconnect(Connection client)
 
 [[nodiscard]] bool NetworkEngine::isValidConnection(Connection connection)
 {
-    if (!isValid(connection)) [[unlikely]] return false;
+    // Registry state only: a peer that closed is caught by the reactor, which marks the connection Disconnecting
+    // before anything is told about it
+    auto ref = lockConnection(connection);
+    if (!ref) [[unlikely]] return false;
+    return ref.get<SocketInfo>().fd != -1 && !ref.has<Disconnecting>();
+}
 
-    auto &socket = g_ConnectionRegistry.get<SocketInfo>(fdToEntity(connection));
-    if (socket.fd == -1) return false;
+// Creates a reactor's epoll instance and listening socket
+bool createReactor(Reactor &reactor, int port)
+{
+    // Used to wake the event loop on shutdown
+    reactor.wakeupFD = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (reactor.wakeupFD == -1)
+    {
+        LOG_ERROR("NetworkEngine", "eventfd failed: {}", strerror(errno));
+        return false;
+    }
 
-    char buffer[1];
-    ssize_t result = recv(socket.fd, buffer, sizeof(buffer), MSG_PEEK);
+    reactor.listener = createListener(reactor, port);
+    if (reactor.listener == -1)
+    {
+        destroyReactor(reactor);
+        return false;
+    }
 
-    if (result < 0) {
-#ifndef _WIN32
-        if (errno == EAGAIN || errno == EWOULDBLOCK)
+    reactor.epollFD = epoll_create1(EPOLL_CLOEXEC);
+    if (reactor.epollFD == -1)
+    {
+        LOG_ERROR("NetworkEngine", "epoll_create1 failed: {}", strerror(errno));
+        destroyReactor(reactor);
+        return false;
+    }
+
+    epoll_event wakeupEvent {};
+    wakeupEvent.events = EPOLLIN;
+    wakeupEvent.data.fd = reactor.wakeupFD;
+
+    epoll_event listenEvent {};
+    listenEvent.events = EPOLLIN | EPOLLET;
+    listenEvent.data.fd = reactor.listener;
+
+    if (epoll_ctl(reactor.epollFD, EPOLL_CTL_ADD, reactor.wakeupFD, &wakeupEvent) == -1 ||
+        epoll_ctl(reactor.epollFD, EPOLL_CTL_ADD, reactor.listener, &listenEvent) == -1)
+    {
+        LOG_ERROR("NetworkEngine", "Failed to register reactor descriptors: {}", strerror(errno));
+        destroyReactor(reactor);
+        return false;
+    }
+    return true;
+}
+
+// Closes a reactor's descriptors and drops whatever is left in its registry
+void destroyReactor(Reactor &reactor)
+{
+    std::lock_guard lock(reactor.mutex);
+
+    // Close the sockets of clients that are still connected
+    for (auto entity : reactor.registry.view<ClientConnection>())
+        close(entityToFD(reactor, entity));
+
+    if (reactor.listener != -1)
+    {
+        auto listener = reactor.registry.view<ServerConnection>();
+        for (auto entity : listener)
+            destroyConnectionEntity(reactor, entity);
+        close(reactor.listener);
+    }
+    if (reactor.wakeupFD != -1) close(reactor.wakeupFD);
+    if (reactor.epollFD != -1) close(reactor.epollFD);
+
+    reactor.registry.clear();
+    reactor.listener = -1;
+    reactor.wakeupFD = -1;
+    reactor.epollFD = -1;
+}
+
+// Wakes the reactor thread if it is blocked waiting for events
+void wakeReactor(Reactor &reactor)
+{
+    if (reactor.wakeupFD == -1) return;
+    uint64_t value = 1;
+    [[maybe_unused]] auto result = write(reactor.wakeupFD, &value, sizeof(value));
+}
+
+// Registers a client socket with the reactor (edge-triggered)
+bool watchConnection(Reactor &reactor, int fd)
+{
+    epoll_event event {};
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.fd = fd;
+    return epoll_ctl(reactor.epollFD, EPOLL_CTL_ADD, fd, &event) != -1;
+}
+
+// Dispatches a single readiness notification
+void handleEvent(Reactor &reactor, const epoll_event &event)
+{
+    int fd = event.data.fd;
+
+    // Shutdown request; the loop condition takes care of the rest
+    if (fd == reactor.wakeupFD)
+    {
+        uint64_t value;
+        [[maybe_unused]] auto result = read(reactor.wakeupFD, &value, sizeof(value));
+        return;
+    }
+
+    // Listening socket is ready; drain the accept queue
+    if (fd == reactor.listener)
+    {
+        if (isAcceptQueueFull(reactor.listener)) [[unlikely]]
+            reactor.backlogOverflows.fetch_add(1, std::memory_order_relaxed);
+
+        while (acceptClient(reactor));
+        return;
+    }
+
+    // Stale event for a connection that was closed earlier in this batch
+    if (!isValid(fd)) [[unlikely]] return;
+
+    if (event.events & (EPOLLERR | EPOLLHUP))
+    {
+        NetworkEngine::disconnect(fd);
+        return;
+    }
+
+    // Socket has room again; continue writing its queue
+    if ((event.events & EPOLLOUT) && !flushConnection(fd))
+    {
+        NetworkEngine::disconnect(fd);
+        return;
+    }
+
+    // Read whatever is left before honoring a half-close from the peer
+    if (event.events & (EPOLLIN | EPOLLRDHUP))
+        NetworkEngine::receiveData(fd);
+
+    if ((event.events & EPOLLRDHUP) && isValid(fd))
+        NetworkEngine::disconnect(fd);
+}
+
+// Writes as much of a connection's send queue as the socket accepts. The caller holds the reactor's mutex.
+FlushResult flushSendQueue(ConnectionRef &connection)
+{
+    auto &queue = connection.get<SendQueue>();
+    auto &metrics = connection.get<Metrics>();
+    int fd = connection.get<SocketInfo>().fd;
+
+    iovec iov[MAX_IOV_PER_WRITE];
+    while (!queue.empty())
+    {
+        // sendmsg() is writev() with flags, which we need for MSG_NOSIGNAL
+        msghdr message {};
+        message.msg_iov = iov;
+        message.msg_iovlen = queue.gather(iov, MAX_IOV_PER_WRITE);
+
+        ssize_t bytesSent = sendmsg(fd, &message, SEND_FLAGS);
+        if (bytesSent > 0)
         {
-#else
-        if (WSAGetLastError() == WSAEWOULDBLOCK)
-#endif
-            return true; // Non-blocking operation
+            queue.consume(bytesSent);
+            metrics.bytesSent += bytesSent;
+            continue;
         }
-        return false; // Other errors
+
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return FlushResult::Pending;
+
+        LOG_ERROR("NetworkEngine", "Error sending data: {}", strerror(errno));
+        queue.clear();
+        queue.failed = true;
+        armExpiry(connection);
+        return FlushResult::Failed;
     }
-    return true; // Valid if data is available
+    return FlushResult::Drained;
 }
 
-void processConnectionsInternal(const std::function<bool(Connection)> &predicate)
+// Queues a frame and writes it right away if nothing was waiting, rather than waiting for EPOLLOUT.
+// Returns false if the connection's queue has failed. The caller holds the reactor's mutex.
+bool enqueueFrame(ConnectionRef &connection, SharedPayload payload, bool &backpressureChanged)
 {
-    //Logger::log(LogLevel::DEBUG, "Checking if connections need to be purged...");
+    auto &queue = connection.get<SendQueue>();
+    if (queue.failed) [[unlikely]] return false;
+
+    bool wasIdle = queue.empty();
+    queue.push(std::move(payload));
 
-    std::vector<Connection> connectionsToPurge;
+    if (wasIdle && flushSendQueue(connection) == FlushResult::Failed)
+        return false;
 
-    auto clients = g_ConnectionRegistry.view<ClientConnection>();
-    for (auto client: clients)
-        if (predicate(entityToFD(client)))
-            connectionsToPurge.emplace_back(entityToFD(client));
+    backpressureChanged = updateBackpressure(connection);
+    return true;
+}
 
-    for (auto client: connectionsToPurge)
-        NetworkEngine::disconnect(client);
+// Flushes a connection after EPOLLOUT; returns false if the connection is broken
+bool flushConnection(Connection connection)
+{
+    bool backpressureChanged;
+    bool throttled;
+    {
+        auto ref = lockConnection(connection);
+        if (!ref || !ref.has<SendQueue>()) [[unlikely]] return true;
 
-    // Notify the event thread
-    g_NetworkEngineCV.notify_one();
+        if (flushSendQueue(ref) == FlushResult::Failed) return false;
+
+        backpressureChanged = updateBackpressure(ref);
+        throttled = ref.get<SendQueue>().throttled;
+    }
+
+    if (backpressureChanged)
+        NetworkEngine::backpressure(Connection(connection), bool(throttled));
+    return true;
 }
 
-void validateConnections()
+// Applies the high/low watermarks to a connection's send queue; returns true if its throttled state changed.
+// The caller holds the reactor's mutex.
+bool updateBackpressure(ConnectionRef &connection)
 {
-    //Logger::log(LogLevel::DEBUG, "Validating connections...");
-    processConnectionsInternal([](Connection connection)
+    auto &queue = connection.get<SendQueue>();
+    if (!queue.throttled && queue.bytes() > g_NetworkConfig.sendHighWatermark)
     {
-        // Purge invalid or inactive connections
-        bool isValid = NetworkEngine::isValidConnection(connection);
-        bool isActive = NetworkEngine::isActiveConnection(connection, 30);
-        return !(isValid && isActive);
-    });
+        queue.throttled = true;
+        queue.throttledSince = std::chrono::steady_clock::now();
+        armExpiry(connection);  // The stall deadline may come before the idle one
+        return true;
+    }
+
+    if (queue.throttled && queue.bytes() <= g_NetworkConfig.sendLowWatermark)
+    {
+        queue.throttled = false;
+        return true;
+    }
+    return false;
 }
 
-void processConnections()
+// Earliest time a client has to be looked at again: when it goes idle, when its throttled queue counts as
+// stalled, or right away once a write failed. Empty if none applies. The caller holds the reactor's mutex.
+std::optional<std::chrono::steady_clock::time_point> expiryDeadline(ConnectionRef &connection)
 {
-    auto clientView = g_ConnectionRegistry.view<ClientConnection>();
+    auto &queue = connection.get<SendQueue>();
+    if (queue.failed) return std::chrono::steady_clock::now();
 
-    // Check and process connections with data
-    for (auto clientEntity : clientView)
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+    if (g_NetworkConfig.idleTimeout > 0)
+        deadline = connection.get<ClientInfo>().lastActivityTime + std::chrono::seconds(g_NetworkConfig.idleTimeout);
+
+    if (queue.throttled && g_NetworkConfig.slowClientTimeout > 0)
     {
-        // This way of checking if there is pending data is terrible
-        Connection client = entityToFD(clientEntity);
-        processConnectionsInternal([&](Connection)
-        {
-            std::string message = NetworkEngine::receiveData(client);
+        auto stalled = queue.throttledSince + std::chrono::seconds(g_NetworkConfig.slowClientTimeout);
+        if (!deadline || stalled < *deadline) deadline = stalled;
+    }
+    return deadline;
+}
+
+// (Re)arms a client's expiry timer. Activity does not touch the timer; when it fires early the deadline
+// is recomputed from lastActivityTime instead. The caller holds the reactor's mutex.
+void armExpiry(ConnectionRef &connection)
+{
+    int fd = connection.get<SocketInfo>().fd;
+    if (auto deadline = expiryDeadline(connection))
+        connection.reactor->timers.schedule(fd, *deadline);
+    else
+        connection.reactor->timers.cancel(fd);
+}
+
+// Disconnects the clients whose timers fired and turned out to be due; only those clients are looked at
+void expireConnections(Reactor &reactor, std::chrono::steady_clock::time_point now)
+{
+    std::vector<std::pair<Connection, std::string>> connectionsToPurge;
+    {
+        std::lock_guard lock(reactor.mutex);
+        reactor.expired.clear();
+        reactor.timers.advance(now, reactor.expired);
 
-            if (!NetworkEngine::hasPendingData(client) && message.empty())
-                return false; // Mark for purging
+        for (auto fd : reactor.expired)
+        {
+            auto entity = findConnection(reactor, static_cast<Connection>(fd));
+            if (entity == entt::null || reactor.registry.all_of<Disconnecting>(entity)) continue;
 
-            // Process message if received
-            if (!message.empty())
+            ConnectionRef connection {&reactor, entity, {}};
+            auto deadline = expiryDeadline(connection);
+            if (!deadline || *deadline > now)
             {
-                return false;
+                armExpiry(connection);
+                continue;
             }
-            return false; // Purge if no message is received and there is no pending data
-        });
+
+            auto &queue = connection.get<SendQueue>();
+            if (queue.failed)
+                connectionsToPurge.emplace_back(fd, "send failed");
+            else if (queue.throttled && g_NetworkConfig.slowClientTimeout > 0 &&
+                     now - queue.throttledSince >= std::chrono::seconds(g_NetworkConfig.slowClientTimeout))
+                connectionsToPurge.emplace_back(fd, "send queue stalled");
+            else
+                connectionsToPurge.emplace_back(fd, "idle for " + std::to_string(g_NetworkConfig.idleTimeout) + 's');
+        }
+    }
+
+    for (const auto &[connection, reason] : connectionsToPurge)
+    {
+        LOG_WARNING("NetworkEngine", "Disconnecting client {}: {}", connection, reason);
+        NetworkEngine::disconnect(connection);
     }
 }
 
-[[nodiscard]] Connection createConnection(bool isServer, int port = 0)
+// Event loop; blocks in epoll_wait() until sockets are ready or the engine stops
+void runReactor(const ServerModule &engine, Reactor &reactor)
 {
-    int fd = createAndConfigureSocket(isServer, port);
+    t_Reactor = &reactor;
+
+    epoll_event events[MAX_EVENTS_PER_WAIT];
+    auto lastTick = std::chrono::steady_clock::now();
+
+    while (engine.isActive())
+    {
+        int count = epoll_wait(reactor.epollFD, events, MAX_EVENTS_PER_WAIT, REACTOR_TICK_MS);
+        if (count == -1)
+        {
+            if (errno == EINTR) continue;
+            LOG_ERROR("NetworkEngine", "epoll_wait failed: {}", strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < count; i++)
+            handleEvent(reactor, events[i]);
+
+        tickReactor(reactor, lastTick);
+        reactor.arena.release();
+    }
+}
+
+// Expires connections and samples the accept rate at most once per tick
+void tickReactor(Reactor &reactor, std::chrono::steady_clock::time_point &lastTick)
+{
+    auto now = std::chrono::steady_clock::now();
+    if (now - lastTick < std::chrono::milliseconds(REACTOR_TICK_MS)) return;
+
+    expireConnections(reactor, now);
+
+    double elapsed = std::chrono::duration<double>(now - lastTick).count();
+    size_t accepted = reactor.accepted.load(std::memory_order_relaxed);
+    reactor.acceptRate.store(static_cast<double>(accepted - reactor.acceptedAtLastTick) / elapsed,
+                             std::memory_order_relaxed);
+    reactor.acceptedAtLastTick = accepted;
+
+    size_t overflows = reactor.backlogOverflows.load(std::memory_order_relaxed);
+    if (overflows != reactor.overflowsAtLastTick) [[unlikely]]
+        LOG_WARNING("NetworkEngine", "Accept queue of reactor #{} overflowed {} time(s); consider a larger backlog",
+                    reactor.id, overflows - reactor.overflowsAtLastTick);
+    reactor.overflowsAtLastTick = overflows;
+    lastTick = now;
+}
+
+// Creates a reactor's listening socket and its server entity
+[[nodiscard]] Connection createListener(Reactor &reactor, int port)
+{
+    int fd = createAndConfigureSocket(true, port);
     if (fd == -1)
     {
-        Logger::log(LogLevel::Error, "Failed to create socket for connection");
+        LOG_ERROR("NetworkEngine", "Failed to create socket for connection");
         return -1;
     }
 
-    sockaddr_in clientAddress {}; // Can be empty for now
-    auto connection = createConnectionEntity(fd, clientAddress, isServer);
+    // Record the address the kernel actually bound (matters when port 0 was requested)
+    sockaddr_in serverAddress {};
+    socklen_t serverAddressLength = sizeof(serverAddress);
+    getsockname(fd, reinterpret_cast<sockaddr *>(&serverAddress), &serverAddressLength);
 
-    // For servers, just return the FD; no entity is needed
-    if (isServer && g_ServerConnection != -1)
+    std::lock_guard lock(reactor.mutex);
+    auto connection = createConnectionEntity(reactor, fd, serverAddress, true);
+    if (connection == entt::null)
     {
-        g_ServerConnection = entityToFD(connection);
-        Logger::log(LogLevel::Info, "Server connection entity created");
+        LOG_ERROR("NetworkEngine", "File descriptor {} is outside the connection index", fd);
+        close(fd);
+        return -1;
     }
-    return entityToFD(connection);
+
+    LOG_INFO("NetworkEngine", "Created server socket {} for reactor #{}", fd, reactor.id);
+    return fd;
 }
 
-[[nodiscard]] entt::entity createConnectionEntity(int fd, sockaddr_in clientAddress, bool isServer = false)
+// Creates a connection entity in the reactor's registry and publishes it in the fd index.
+// The caller must hold the reactor's mutex.
+[[nodiscard]] entt::entity createConnectionEntity(Reactor &reactor, int fd, sockaddr_in clientAddress, bool isServer = false)
 {
+    if (!g_FDIndex.contains(fd)) [[unlikely]] return entt::null;
+
     // Create entity
-    auto connection = g_ConnectionRegistry.create();
+    auto connection = reactor.registry.create();
 
-    if (isServer && g_ServerConnection != -1)
+    if (isServer)
     {
-        g_ConnectionRegistry.emplace<ServerConnection>(connection);
-        g_ConnectionRegistry.emplace<ServerInfo>(connection);
+        reactor.registry.emplace<ServerConnection>(connection);
+        reactor.registry.emplace<ServerInfo>(connection);
     }
     else
     {
-        g_ConnectionRegistry.emplace<ClientConnection>(connection);
-        g_ConnectionRegistry.emplace<ClientInfo>(connection);
+        reactor.registry.emplace<ClientConnection>(connection);
+        reactor.registry.emplace<ClientInfo>(connection);
+        reactor.registry.emplace<ReadBuffer>(connection);
+        reactor.registry.emplace<SendQueue>(connection);
+    }
+    reactor.registry.emplace<SocketInfo>(connection, fd, clientAddress);
+    reactor.registry.emplace<Metrics>(connection);
+
+    if (!isServer)
+    {
+        ConnectionRef client {&reactor, connection, {}};
+        armExpiry(client);
     }
-    g_ConnectionRegistry.emplace<SocketInfo>(connection, fd, clientAddress);
-    g_ConnectionRegistry.emplace<Metrics>(connection);
 
+    g_FDIndex.publish(fd, &reactor, connection);
     return connection;
 }
 
-// Accepts a client and returns a Connection ID if successful
-bool acceptClient()
+// Removes a connection entity and its fd index entry. The caller must hold the reactor's mutex.
+void destroyConnectionEntity(Reactor &reactor, entt::entity connection)
+{
+    if (!reactor.registry.valid(connection)) [[unlikely]] return;
+
+    int fd = reactor.registry.get<SocketInfo>(connection).fd;
+    if (g_FDIndex.contains(fd))
+    {
+        g_FDIndex.clear(fd);
+        reactor.timers.cancel(fd);
+    }
+
+    reactor.registry.destroy(connection);
+}
+
+// Accepts a pending client; returns false once the accept queue is empty
+bool acceptClient(Reactor &reactor)
 {
     sockaddr_in clientAddress {};
     socklen_t clientAddressLength = sizeof(clientAddress);
 
-    auto serverFD = NetworkEngine::getFD(g_ServerConnection);
-    int clientFD = accept(serverFD, reinterpret_cast<sockaddr *>(&clientAddress), &clientAddressLength);
-    if (clientFD == -1) return false;
-
-    // Set client FD to non-blocking
 #ifndef _WIN32
-    int flags = fcntl(clientFD, F_GETFL, 0);
-    if (flags == -1 || fcntl(clientFD, F_SETFL, flags | O_NONBLOCK) == -1)
+    // The accepted socket comes back non-blocking and close-on-exec in a single syscall
+    int clientFD = accept4(reactor.listener, reinterpret_cast<sockaddr *>(&clientAddress), &clientAddressLength,
+                           SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (clientFD == -1)
     {
+        if (errno == EINTR || errno == ECONNABORTED) return true;
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+            LOG_ERROR("NetworkEngine", "accept4 failed: {}", strerror(errno));
+        return false; // The batch ends once the queue is drained
+    }
 #else
+    int clientFD = accept(reactor.listener, reinterpret_cast<sockaddr *>(&clientAddress), &clientAddressLength);
+    if (clientFD == -1)
+        return WSAGetLastError() == WSAECONNRESET;
+
+    // Set client FD to non-blocking
     u_long mode = 1; // 1 = non-blocking
     if (ioctlsocket(clientFD, FIONBIO, &mode) != 0)
     {
-#endif
-        Logger::log(LogLevel::Error, "Failed to set client FD to non-blocking mode");
-        close(clientFD);
-        return false;
+        LOG_ERROR("NetworkEngine", "Failed to set client FD to non-blocking mode");
+        closesocket(clientFD);
+        return true;
     }
+#endif
+
+    {
+        std::lock_guard lock(reactor.mutex);
+
+        // Create connection entity
+        auto client = createConnectionEntity(reactor, clientFD, clientAddress);
+        if (client == entt::null)
+        {
+            LOG_ERROR("NetworkEngine", "Client FD {} is outside the connection index", clientFD);
+            close(clientFD);
+            return true;
+        }
 
-    // Create connection entity
-    auto client = createConnectionEntity(clientFD, clientAddress);
+        // Hand the socket to the reactor
+        if (!watchConnection(reactor, clientFD))
+        {
+            LOG_ERROR("NetworkEngine", "Failed to register client FD with the reactor: {}", strerror(errno));
+            destroyConnectionEntity(reactor, client);
+            close(clientFD);
+            return true;
+        }
+    }
 
-    NetworkEngine::clientAccepted(entityToFD(client));
+    reactor.accepted.fetch_add(1, std::memory_order_relaxed);
+    g_ClientCount.fetch_add(1, std::memory_order_relaxed);
+    NetworkEngine::clientAccepted(Connection(clientFD));
     return true;
 }
 
+// Checks whether a listener's accept queue is at capacity, i.e. the kernel is dropping new SYNs
+bool isAcceptQueueFull(int listenerFD)
+{
+#if !defined(_WIN32) && defined(TCP_INFO)
+    // For listening sockets the kernel reports the queue length in tcpi_unacked and the backlog in tcpi_sacked
+    tcp_info info {};
+    socklen_t length = sizeof(info);
+    if (getsockopt(listenerFD, IPPROTO_TCP, TCP_INFO, &info, &length) == 0)
+        return info.tcpi_unacked > info.tcpi_sacked;
+#endif
+    return false;
+}
+
 [[nodiscard]] int createAndConfigureSocket(bool isServer, int port = 0)
 {
     int fd = socket(AF_INET, SOCK_STREAM, 0);
     if (fd < 0)
     {
 #ifndef _WIN32
-        Logger::log(LogLevel::Error, "Socket creation failed: " + std::string(strerror(errno)));
+        LOG_ERROR("NetworkEngine", "Socket creation failed: {}", strerror(errno));
 #else
-        Logger::log(LogLevel::Error, "Socket creation failed: " + std::to_string(WSAGetLastError()));
+        LOG_ERROR("NetworkEngine", "Socket creation failed: {}", WSAGetLastError());
 #endif
         return -1;
     }
@@ -641,7 +1206,7 @@ bool acceptClient()
     if (ioctlsocket(fd, FIONBIO, &mode) != 0)
     {
 #endif
-        Logger::log(LogLevel::Error, "Failed to set socket to non-blocking mode");
+        LOG_ERROR("NetworkEngine", "Failed to set socket to non-blocking mode");
         close(fd);
         return -1;
     }
@@ -650,13 +1215,39 @@ bool acceptClient()
     int enableKeepalive = 1;
     setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &enableKeepalive, sizeof(enableKeepalive));
 
+#if defined(TCP_KEEPIDLE) && defined(TCP_KEEPINTVL) && defined(TCP_KEEPCNT)
+    // Probing starts halfway through the timeout and the rest is split between the probes, so a peer that
+    // vanished without a FIN surfaces as a socket error. Accepted sockets inherit this from the listener.
+    if (g_NetworkConfig.keepaliveTimeout > 0)
+    {
+        int idle = std::max(1, g_NetworkConfig.keepaliveTimeout / 2);
+        int interval = std::max(1, (g_NetworkConfig.keepaliveTimeout - idle) / KEEPALIVE_PROBES);
+        int probes = KEEPALIVE_PROBES;
+        setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle));
+        setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &interval, sizeof(interval));
+        setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &probes, sizeof(probes));
+    }
+#endif
+
     if (isServer)
     {
+        // Every reactor binds its own listening socket to the same port; the kernel load-balances between them
+        int enableReuse = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enableReuse, sizeof(enableReuse));
+#ifdef SO_REUSEPORT
+        if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &enableReuse, sizeof(enableReuse)) == -1)
+        {
+            LOG_ERROR("NetworkEngine", "Failed to enable SO_REUSEPORT: {}", strerror(errno));
+            close(fd);
+            return -1;
+        }
+#endif
+
         // Configure server-specific settings
         sockaddr_in serverAddress {};
         if (!createServerAddress(serverAddress, port))
         {
-            Logger::log(LogLevel::Error, "Failed to create server address");
+            LOG_ERROR("NetworkEngine", "Failed to create server address");
             close(fd);
             return -1;
         }
@@ -664,25 +1255,25 @@ bool acceptClient()
         if (!bindAddress(fd, serverAddress))
         {
 #ifndef _WIN32
-            Logger::log(LogLevel::Error, "Bind failed: " + std::string(strerror(errno)));
+            LOG_ERROR("NetworkEngine", "Bind failed: {}", strerror(errno));
 #else
-            Logger::log(LogLevel::Error, "Bind failed: " + std::to_string(WSAGetLastError()));
+            LOG_ERROR("NetworkEngine", "Bind failed: {}", WSAGetLastError());
 #endif
             close(fd);
             return -1;
         }
 
-        if (!startListening(fd))
+        if (!startListening(fd, g_NetworkConfig.backlog))
         {
 #ifndef _WIN32
-            Logger::log(LogLevel::Error, "Listen failed: " + std::string(strerror(errno)));
+            LOG_ERROR("NetworkEngine", "Listen failed: {}", strerror(errno));
 #else
-            Logger::log(LogLevel::Error, "Listen failed: " + std::to_string(WSAGetLastError()));
+            LOG_ERROR("NetworkEngine", "Listen failed: {}", WSAGetLastError());
 #endif
             close(fd);
             return -1;
         }
-        Logger::log(LogLevel::Info, "Server socket configured to listen on port " + std::to_string(port));
+        LOG_INFO("NetworkEngine", "Server socket configured to listen on port {}", port);
     }
     return fd;
 }
@@ -712,29 +1303,59 @@ inline bool bindAddress(int serverFD, sockaddr_in serverAddress)
 }
 
 // Makes the server file descripter listen for connections
-inline bool startListening(int serverFD)
+inline bool startListening(int serverFD, int backlog)
 {
-    if (listen(serverFD, 5) >= 0) [[likely]] return true;
+    if (listen(serverFD, backlog) >= 0) [[likely]] return true;
     return false;
 }
 
-// Returns the file descriptor of a specified entity
-inline Connection entityToFD(entt::entity entity)
+// Returns the file descriptor of a specified entity. The caller must hold the reactor's mutex.
+inline Connection entityToFD(Reactor &reactor, entt::entity entity)
+{
+    return reactor.registry.get<SocketInfo>(entity).fd;
+}
+
+// Resolves a connection to its owning reactor and locks it (O(1)); empty if the connection is unknown
+ConnectionRef lockConnection(Connection connection)
+{
+    Reactor *reactor = g_FDIndex.owner(connection);
+    if (!reactor) return {};
+
+    std::unique_lock lock(reactor->mutex);
+
+    // The connection may have been closed before the lock was taken
+    if (g_FDIndex.owner(connection) != reactor) return {};
+
+    auto entity = g_FDIndex.entity(connection);
+    if (entity == entt::null || !reactor->registry.valid(entity)) [[unlikely]] return {};
+    return {reactor, entity, std::move(lock)};
+}
+
+// Looks up a connection owned by a reactor whose mutex the caller already holds; null if it belongs elsewhere
+entt::entity findConnection(Reactor &reactor, Connection connection)
 {
-    return g_ConnectionRegistry.get<SocketInfo>(entity).fd;
+    if (g_FDIndex.owner(connection) != &reactor) return entt::null;
+
+    auto entity = g_FDIndex.entity(connection);
+    if (entity == entt::null || !reactor.registry.valid(entity)) [[unlikely]] return entt::null;
+    return entity;
 }
 
-entt::entity fdToEntity(Connection connection)
+// Sizes the fd index to the process' descriptor limit
+void createFDIndex()
 {
-    for (const entt::entity ent : g_ConnectionRegistry.view<SocketInfo>())
-        if (g_ConnectionRegistry.get<SocketInfo>(ent).fd == connection)
-            return ent;
-    return entt::null;
+    size_t capacity = MAX_FD_INDEX_SIZE;
+#ifndef _WIN32
+    rlimit limit {};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+        capacity = std::min<size_t>(limit.rlim_cur, MAX_FD_INDEX_SIZE);
+#endif
+    g_FDIndex.reset(capacity);
 }
 
 // Checks if a connection is valid
 inline bool isValid(Connection connection)
 {
-    entt::entity connectionEntity = fdToEntity(connection);
-    return g_ConnectionRegistry.valid(connectionEntity) && g_ConnectionRegistry.get<SocketInfo>(connectionEntity).fd != -1;
-}
\ No newline at end of file
+    auto ref = lockConnection(connection);
+    return ref && ref.get<SocketInfo>().fd != -1;
+}
@@ -0,0 +1,59 @@
+//
+// Created by msullivan on 12/7/24.
+//
+
+#include "SendQueue.h"
+
+void SendQueue::push(SharedPayload payload)
+{
+    auto &entry = m_Entries.emplace_back();
+    writeFrameHeader(entry.header, static_cast<uint32_t>(payload->size()));
+    entry.payload = std::move(payload);
+    m_Bytes += FRAME_HEADER_SIZE + entry.payload->size();
+}
+
+size_t SendQueue::gather(iovec *iov, size_t maxIov) const
+{
+    size_t count = 0;
+    for (const auto &entry : m_Entries)
+    {
+        if (count + 2 > maxIov) break;
+
+        // The first entry may be partially written
+        if (entry.offset < FRAME_HEADER_SIZE)
+        {
+            iov[count++] = {const_cast<char *>(entry.header) + entry.offset, FRAME_HEADER_SIZE - entry.offset};
+            if (!entry.payload->empty())
+                iov[count++] = {const_cast<char *>(entry.payload->data()), entry.payload->size()};
+        }
+        else
+        {
+            size_t written = entry.offset - FRAME_HEADER_SIZE;
+            iov[count++] = {const_cast<char *>(entry.payload->data()) + written, entry.payload->size() - written};
+        }
+    }
+    return count;
+}
+
+void SendQueue::consume(size_t bytes)
+{
+    m_Bytes -= bytes;
+    while (bytes > 0 && !m_Entries.empty())
+    {
+        auto &entry = m_Entries.front();
+        size_t remaining = FRAME_HEADER_SIZE + entry.payload->size() - entry.offset;
+        if (bytes < remaining)
+        {
+            entry.offset += bytes;
+            return;
+        }
+        bytes -= remaining;
+        m_Entries.pop_front();
+    }
+}
+
+void SendQueue::clear()
+{
+    m_Entries.clear();
+    m_Bytes = 0;
+}
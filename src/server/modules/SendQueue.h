@@ -0,0 +1,50 @@
+//
+// Created by msullivan on 12/7/24.
+//
+
+#pragma once
+#include "common/Frame.h"
+#include <deque>
+#include <string>
+#include <chrono>
+
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif
+
+// Frames waiting to be written to a connection. Frames are kept whole (header + payload) and
+// handed to the kernel as iovecs, so many small frames leave in a single sendmsg()/writev().
+class SendQueue {
+    struct Entry {
+        char header[FRAME_HEADER_SIZE];
+        SharedPayload payload;
+        size_t offset = 0;      // Bytes of header + payload already written
+    };
+
+    std::deque<Entry> m_Entries;
+    size_t m_Bytes = 0;         // Bytes queued but not yet written
+
+public:
+    // Set while the queue is above the high watermark (until it drains below the low one)
+    bool throttled = false;
+    std::chrono::steady_clock::time_point throttledSince;
+
+    // Set once a write fails; the connection is purged by its reactor
+    bool failed = false;
+
+    // Queues a payload as one frame (by reference; the bytes are not copied)
+    void push(SharedPayload payload);
+
+    // Describes up to maxIov iovecs worth of unwritten data, oldest first; returns the number filled
+    size_t gather(iovec *iov, size_t maxIov) const;
+
+    // Drops bytes the kernel accepted
+    void consume(size_t bytes);
+
+    // Drops everything that is still queued
+    void clear();
+
+    [[nodiscard]] size_t bytes() const { return m_Bytes; }
+    [[nodiscard]] size_t frames() const { return m_Entries.size(); }
+    [[nodiscard]] bool empty() const { return m_Entries.empty(); }
+};
@@ -0,0 +1,117 @@
+//
+// Created by msullivan on 12/9/24.
+//
+
+#include "TimerWheel.h"
+#include <algorithm>
+
+TimerWheel::TimerWheel(Clock::duration resolution, Clock::time_point origin)
+        : m_Resolution(resolution), m_Origin(origin)
+{
+    m_Slots.fill(NIL);
+}
+
+void TimerWheel::schedule(uint32_t id, Clock::time_point deadline)
+{
+    if (id >= m_Timers.size())
+        m_Timers.resize(id + 1);
+
+    if (m_Timers[id].slot != NIL)
+        unlink(id);
+    else
+        m_Size++;
+
+    // Round up so a timer never fires early; anything already due fires on the next tick
+    auto offset = deadline - m_Origin;
+    uint64_t expiry = offset.count() > 0 ? static_cast<uint64_t>((offset + m_Resolution - Clock::duration(1)) / m_Resolution) : 0;
+    expiry = std::max(expiry, m_Now + 1);
+    expiry = std::min(expiry, m_Now + MAX_DELTA);
+
+    m_Timers[id].expiry = expiry;
+    link(id);
+}
+
+void TimerWheel::cancel(uint32_t id)
+{
+    if (!scheduled(id)) return;
+    unlink(id);
+    m_Size--;
+}
+
+void TimerWheel::advance(Clock::time_point now, std::vector<uint32_t> &expired)
+{
+    auto offset = now - m_Origin;
+    if (offset.count() < 0) return;
+
+    auto target = static_cast<uint64_t>(offset / m_Resolution);
+    while (m_Now < target)
+    {
+        m_Now++;
+
+        // Whenever a level wraps, the current slot of the level above is due and moves down.
+        // Higher levels go first since they may refill a lower level's current slot.
+        unsigned wrapped = 0;
+        while (wrapped + 1 < LEVELS && (m_Now & ((uint64_t(1) << (LEVEL_BITS * (wrapped + 1))) - 1)) == 0)
+            wrapped++;
+        for (unsigned level = wrapped; level > 0; level--)
+            cascade(level);
+
+        uint32_t &head = m_Slots[m_Now & (SLOTS - 1)];
+        while (head != NIL)
+        {
+            uint32_t id = head;
+            unlink(id);
+            m_Size--;
+            expired.emplace_back(id);
+        }
+    }
+}
+
+// Puts a timer in the slot matching how far away its expiry is
+void TimerWheel::link(uint32_t id)
+{
+    auto &timer = m_Timers[id];
+    uint64_t delta = timer.expiry - m_Now;
+
+    unsigned level = 0;
+    while (level + 1 < LEVELS && delta >= (uint64_t(1) << (LEVEL_BITS * (level + 1))))
+        level++;
+
+    timer.slot = level * SLOTS + ((timer.expiry >> (LEVEL_BITS * level)) & (SLOTS - 1));
+    timer.prev = NIL;
+    timer.next = m_Slots[timer.slot];
+    if (timer.next != NIL)
+        m_Timers[timer.next].prev = id;
+    m_Slots[timer.slot] = id;
+}
+
+void TimerWheel::unlink(uint32_t id)
+{
+    auto &timer = m_Timers[id];
+    if (timer.prev != NIL)
+        m_Timers[timer.prev].next = timer.next;
+    else
+        m_Slots[timer.slot] = timer.next;
+
+    if (timer.next != NIL)
+        m_Timers[timer.next].prev = timer.prev;
+
+    timer.prev = NIL;
+    timer.next = NIL;
+    timer.slot = NIL;
+}
+
+// Re-files the timers of a level's current slot; they are now close enough for a lower level
+void TimerWheel::cascade(unsigned level)
+{
+    uint32_t slot = level * SLOTS + ((m_Now >> (LEVEL_BITS * level)) & (SLOTS - 1));
+    uint32_t id = m_Slots[slot];
+    m_Slots[slot] = NIL;
+
+    while (id != NIL)
+    {
+        uint32_t next = m_Timers[id].next;
+        link(id);
+        id = next;
+    }
+}
@@ -0,0 +1,58 @@
+//
+// Created by msullivan on 12/9/24.
+//
+
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Hierarchical timing wheel (4 levels of 64 slots). Scheduling, cancelling and firing a timer are O(1);
+// advancing only touches the slots that came due. Timers are keyed by small dense ids (file descriptors)
+// and an id holds at most one timer, so scheduling it again moves its deadline.
+class TimerWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    static constexpr unsigned LEVEL_BITS = 6;
+    static constexpr unsigned SLOTS = 1 << LEVEL_BITS;
+    static constexpr unsigned LEVELS = 4;
+    static constexpr uint64_t MAX_DELTA = (uint64_t(1) << (LEVEL_BITS * LEVELS)) - 1;
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    struct Timer {
+        uint64_t expiry = 0;    // Tick at which the timer fires
+        uint32_t prev = NIL;
+        uint32_t next = NIL;
+        uint32_t slot = NIL;    // Index into m_Slots; NIL while unarmed
+    };
+
+    Clock::duration m_Resolution;
+    Clock::time_point m_Origin;
+    uint64_t m_Now = 0;                             // Last tick that was processed
+    std::vector<Timer> m_Timers;                    // Indexed by id
+    std::array<uint32_t, LEVELS * SLOTS> m_Slots;   // Head of each slot's timer list
+    size_t m_Size = 0;
+
+    void link(uint32_t id);
+    void unlink(uint32_t id);
+    void cascade(unsigned level);
+
+public:
+    explicit TimerWheel(Clock::duration resolution, Clock::time_point origin = Clock::now());
+
+    // Arms (or re-arms) the timer for id; deadlines are rounded up to the next tick
+    void schedule(uint32_t id, Clock::time_point deadline);
+
+    // Disarms the timer for id, if any
+    void cancel(uint32_t id);
+
+    // Processes every tick up to now and appends the ids of the timers that fired
+    void advance(Clock::time_point now, std::vector<uint32_t> &expired);
+
+    [[nodiscard]] bool scheduled(uint32_t id) const { return id < m_Timers.size() && m_Timers[id].slot != NIL; }
+    [[nodiscard]] size_t size() const { return m_Size; }
+    [[nodiscard]] bool empty() const { return m_Size == 0; }
+};
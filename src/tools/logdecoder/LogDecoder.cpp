@@ -0,0 +1,274 @@
+//
+// Created by msullivan on 12/11/24.
+//
+
+#include "LogDecoder.h"
+#include "common/Format.h"
+#include <chrono>
+#include <fstream>
+#include <iterator>
+
+// Forward declaration(s)
+const char *levelToString(uint8_t level);
+void appendJSONString(std::string &out, std::string_view text);
+
+LogDecoder::LogDecoder(DecodeOutput output) : m_Output(output)
+{}
+
+bool LogDecoder::decodeFile(const std::string &path, std::ostream &out, std::string &error)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        error = "cannot open file";
+        return false;
+    }
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    if (data.size() < sizeof(BinaryLogFileHeader))
+    {
+        error = "not a binary log";
+        return false;
+    }
+    auto header = readBinaryValue<BinaryLogFileHeader>(data.data());
+    if (std::string_view(header.magic, sizeof(header.magic)) != std::string_view(BINARY_LOG_MAGIC, sizeof(BINARY_LOG_MAGIC)))
+    {
+        error = "not a binary log";
+        return false;
+    }
+    if (header.version != BINARY_LOG_VERSION)
+    {
+        error = "unsupported version " + std::to_string(header.version);
+        return false;
+    }
+    if (header.byteOrder != BINARY_LOG_BYTE_ORDER)
+    {
+        error = "written on a machine with a different byte order";
+        return false;
+    }
+
+    m_Modules.clear();
+    m_Formats.clear();
+
+    size_t offset = sizeof(BinaryLogFileHeader);
+    while (offset + sizeof(BinaryLogEntryHeader) <= data.size())
+    {
+        auto entry = readBinaryValue<BinaryLogEntryHeader>(data.data() + offset);
+        if (entry.size == 0 || entry.type == BinaryLogEntry::End) break;     // Zero fill of an unfinished file
+        if (entry.size < sizeof(BinaryLogEntryHeader) || offset + entry.size > data.size())
+        {
+            error = "truncated entry at offset " + std::to_string(offset);
+            return false;
+        }
+
+        std::string_view body(data.data() + offset + sizeof(BinaryLogEntryHeader), entry.size - sizeof(BinaryLogEntryHeader));
+        switch (entry.type)
+        {
+            case BinaryLogEntry::Module:
+                m_Modules[entry.module] = body;
+            break;
+            case BinaryLogEntry::Format:
+                if (body.size() < sizeof(uint32_t)) break;
+                m_Formats[readBinaryValue<uint32_t>(body.data())] = {entry.module, std::string(body.substr(sizeof(uint32_t)))};
+            break;
+            case BinaryLogEntry::Record:
+                if (body.size() < BINARY_LOG_RECORD_PREFIX || !decodeArguments(body.substr(BINARY_LOG_RECORD_PREFIX)))
+                {
+                    error = "malformed record at offset " + std::to_string(offset);
+                    return false;
+                }
+                writeRecord(out, readBinaryValue<uint64_t>(body.data()), entry.level, entry.module,
+                            readBinaryValue<uint32_t>(body.data() + sizeof(uint64_t)));
+            break;
+            default:
+                // Entry types from a newer writer; their size lets us step over them
+            break;
+        }
+        offset += entry.size;
+    }
+    return true;
+}
+
+// Fills m_Arguments from a record's encoded arguments; returns false if they are cut short
+bool LogDecoder::decodeArguments(std::string_view data)
+{
+    m_Arguments.clear();
+    while (!data.empty())
+    {
+        auto type = static_cast<BinaryArgument>(data[0]);
+        data.remove_prefix(1);
+
+        std::string text;
+        size_t size;
+        switch (type)
+        {
+            case BinaryArgument::Int:
+                if (data.size() < 8) return false;
+                appendFormatArgument(text, readBinaryValue<int64_t>(data.data()));
+                size = 8;
+            break;
+            case BinaryArgument::UInt:
+                if (data.size() < 8) return false;
+                appendFormatArgument(text, readBinaryValue<uint64_t>(data.data()));
+                size = 8;
+            break;
+            case BinaryArgument::Double:
+                if (data.size() < 8) return false;
+                appendFormatArgument(text, readBinaryValue<double>(data.data()));
+                size = 8;
+            break;
+            case BinaryArgument::Pointer:
+                if (data.size() < 8) return false;
+                appendFormatArgument(text, reinterpret_cast<const void *>(readBinaryValue<uint64_t>(data.data())));
+                size = 8;
+            break;
+            case BinaryArgument::Bool:
+                if (data.empty()) return false;
+                appendFormatArgument(text, data[0] != 0);
+                size = 1;
+            break;
+            case BinaryArgument::Char:
+                if (data.empty()) return false;
+                text += data[0];
+                size = 1;
+            break;
+            case BinaryArgument::String:
+            {
+                if (data.size() < sizeof(uint32_t)) return false;
+                auto length = readBinaryValue<uint32_t>(data.data());
+                if (data.size() - sizeof(uint32_t) < length) return false;
+                text.assign(data.substr(sizeof(uint32_t), length));
+                size = sizeof(uint32_t) + length;
+            }
+            break;
+            default:
+                return false;
+        }
+
+        m_Arguments.push_back({type, std::move(text)});
+        data.remove_prefix(size);
+    }
+    return true;
+}
+
+void LogDecoder::writeRecord(std::ostream &out, uint64_t nanoseconds, uint8_t level, uint16_t module, uint32_t format)
+{
+    std::chrono::system_clock::time_point time(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(nanoseconds)));
+    auto moduleIt = m_Modules.find(module);
+    std::string_view moduleName = moduleIt != m_Modules.end() ? std::string_view(moduleIt->second) : "?";
+
+    // A record whose format is unknown still shows its arguments
+    std::string message;
+    auto formatIt = m_Formats.find(format);
+    if (formatIt != m_Formats.end())
+        formatWith(message, formatIt->second.text, m_Arguments.size(), [this](std::string &target, size_t index)
+        {
+            target += m_Arguments[index].text;
+        });
+    else
+    {
+        message = "<unknown format " + std::to_string(format) + ">";
+        for (const auto &argument : m_Arguments)
+            message += ' ' + argument.text;
+    }
+
+    m_Line.clear();
+    if (m_Output == DecodeOutput::Text)
+    {
+        m_Line += '[';
+        m_Timestamps.append(m_Line, time, TimestampPrecision::Microseconds);
+        m_Line += "] [";
+        m_Line += levelToString(level);
+        m_Line += "] ";
+        if (!moduleName.empty())
+        {
+            m_Line += '[';
+            m_Line += moduleName;
+            m_Line += "] ";
+        }
+        m_Line += message;
+    }
+    else
+    {
+        m_Line += "{\"time\":";
+        appendFormatArgument(m_Line, nanoseconds);
+        m_Line += ",\"timestamp\":\"";
+        m_Timestamps.append(m_Line, time, TimestampPrecision::Microseconds);
+        m_Line += "\",\"level\":\"";
+        m_Line += levelToString(level);
+        m_Line += "\",\"module\":";
+        appendJSONString(m_Line, moduleName);
+        m_Line += ",\"format\":";
+        appendJSONString(m_Line, formatIt != m_Formats.end() ? std::string_view(formatIt->second.text) : "");
+        m_Line += ",\"message\":";
+        appendJSONString(m_Line, message);
+        m_Line += ",\"args\":[";
+        for (size_t i = 0; i < m_Arguments.size(); i++)
+        {
+            if (i > 0) m_Line += ',';
+            switch (m_Arguments[i].type)
+            {
+                case BinaryArgument::Int:
+                case BinaryArgument::UInt:
+                case BinaryArgument::Bool:
+                    m_Line += m_Arguments[i].text;
+                break;
+                case BinaryArgument::Double:
+                    // JSON has no nan or inf
+                    if (m_Arguments[i].text.find_first_of("ni") == std::string::npos)
+                        m_Line += m_Arguments[i].text;
+                    else
+                        appendJSONString(m_Line, m_Arguments[i].text);
+                break;
+                default:
+                    appendJSONString(m_Line, m_Arguments[i].text);
+                break;
+            }
+        }
+        m_Line += "]}";
+    }
+    m_Line += '\n';
+    out.write(m_Line.data(), static_cast<std::streamsize>(m_Line.size()));
+}
+
+const char *levelToString(uint8_t level)
+{
+    switch (level)
+    {
+        case 0: return "DEBUG";
+        case 1: return "INFO";
+        case 2: return "WARNING";
+        case 3: return "ERROR";
+        case 4: return "FATAL";
+        default: return "UNKNOWN";
+    }
+}
+
+// Appends text as a quoted JSON string
+void appendJSONString(std::string &out, std::string_view text)
+{
+    static constexpr char HEX[] = "0123456789abcdef";
+
+    out += '"';
+    for (char c : text)
+        switch (c)
+        {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    out += "\\u00";
+                    out += HEX[(c >> 4) & 0xF];
+                    out += HEX[c & 0xF];
+                }
+                else
+                    out += c;
+            break;
+        }
+    out += '"';
+}
@@ -0,0 +1,49 @@
+//
+// Created by msullivan on 12/11/24.
+//
+
+#pragma once
+#include "common/BinaryLog.h"
+#include "common/Timestamp.h"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+enum class DecodeOutput {
+    Text,   // One line per record, like the server's text log without colors
+    JSON    // One JSON object per line
+};
+
+// Renders the records of binary log files. Definitions are tracked per file, since each file carries its own.
+class LogDecoder {
+    struct Format {
+        uint16_t module;
+        std::string text;
+    };
+
+    // One decoded argument
+    struct Argument {
+        BinaryArgument type;
+        std::string text;   // As the server would have formatted it
+    };
+
+    DecodeOutput m_Output;
+    TimestampCache m_Timestamps;
+    std::unordered_map<uint16_t, std::string> m_Modules;
+    std::unordered_map<uint32_t, Format> m_Formats;
+    std::vector<Argument> m_Arguments;
+    std::string m_Line;
+
+    bool decodeArguments(std::string_view data);
+    void writeRecord(std::ostream &out, uint64_t nanoseconds, uint8_t level, uint16_t module, uint32_t format);
+
+public:
+    explicit LogDecoder(DecodeOutput output);
+
+    // Writes every record of one file to out; returns false (after writing what it could) if the file is
+    // unreadable, not a binary log or damaged
+    bool decodeFile(const std::string &path, std::ostream &out, std::string &error);
+};
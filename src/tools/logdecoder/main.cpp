@@ -0,0 +1,53 @@
+#include "LogDecoder.h"
+#include <iostream>
+#include <getopt.h>
+
+// Forward declaration(s)
+void printUsage();
+
+int main(int argc, char **argv)
+{
+    DecodeOutput output = DecodeOutput::Text;
+    int opt;
+    while ((opt = getopt(argc, argv, "jh")) != -1)
+        switch (opt)
+        {
+            case 'j':
+                output = DecodeOutput::JSON;
+            break;
+            case 'h':
+                printUsage();
+            return 0;
+            case '?':
+            default:
+                printUsage();
+            return -1;
+        }
+
+    if (optind == argc)
+    {
+        printUsage();
+        return -1;
+    }
+
+    // Files are decoded in the order given, e.g. xserver.binlog.0 xserver.binlog.1 ...
+    LogDecoder decoder(output);
+    int result = 0;
+    for (int i = optind; i < argc; i++)
+    {
+        std::string error;
+        if (!decoder.decodeFile(argv[i], std::cout, error))
+        {
+            std::cerr << argv[i] << ": " << error << std::endl;
+            result = 1;
+        }
+    }
+    return result;
+}
+
+void printUsage()
+{
+    std::cout << "Usage: logdecoder [-j] file..." << std::endl;
+    std::cout << "  -j             Write one JSON object per record instead of text" << std::endl;
+    std::cout << "  -h             Display this help message" << std::endl;
+}